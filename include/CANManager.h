@@ -1,8 +1,13 @@
-// Simple wrapper around Adafruit_MCP2515 for reception (and future transmit)
+// CAN reception, decoding and transmit for the deck. The controller sits
+// behind a CanTransport: the on-board MCP2515 by default, or any other
+// transport (e.g. SocketCAN on Linux) set before begin().
 #pragma once
-#include <Adafruit_MCP2515.h>
 #include <Arduino.h>
 #include "HardwareConfig.h"
+#include "CanSignal.h"
+#include "CanProfile.h"
+#include "CanTransport.h"
+#include "Mcp2515Transport.h"
 
 class CANManager
 {
@@ -70,38 +75,128 @@ public:
         uint8_t leftStalkCrc = 0;
         TurnIndicatorStalkStatus turnIndicatorStalkStatus = TurnIndicatorStalkStatus::Idle;
         WashWipeButtonStatus washWipeButtonStatus = WashWipeButtonStatus::NotPressed;
+        uint8_t reserved = 0; // bits 19-23, unused by the SCCM
         uint32_t lastRxMs = 0;
     };
 
-    explicit CANManager(uint8_t csPin = PIN_CAN_CS) : _mcp(csPin) {}
+    // Wire layouts. Both poll() and the transmit path are generated from these,
+    // so TX and RX cannot disagree on bit positions.
+    using RightDoorStatusFrame = CanSignal::Message<
+        0x103, 8,
+        CanSignal::Field<&RightDoorStatusMsg::rearIntSwitchPressed, 32, 1>>;
+
+    using FrontLightingFrame = CanSignal::Message<
+        0x3F5, 8,
+        CanSignal::Field<&FrontLightingMsg::indicatorLeftRequest, 0, 2>,
+        CanSignal::Field<&FrontLightingMsg::indicatorRightRequest, 2, 2>>;
+
+    using SCCMLeftStalkFrame = CanSignal::Message<
+        0x249, 3,
+        CanSignal::Field<&SCCMLeftStalkMsg::leftStalkCrc, 0, 8>,
+        CanSignal::Field<&SCCMLeftStalkMsg::leftStalkCounter, 8, 4>,
+        CanSignal::Field<&SCCMLeftStalkMsg::highBeamStalkStatus, 12, 2>,
+        CanSignal::Field<&SCCMLeftStalkMsg::washWipeButtonStatus, 14, 2>,
+        CanSignal::Field<&SCCMLeftStalkMsg::turnIndicatorStalkStatus, 16, 3, CanSignal::ByteOrder::Intel, 0, 5>,
+        CanSignal::Field<&SCCMLeftStalkMsg::reserved, 19, 5>>;
+
+    // Payload bits whose change is worth a decode. The SCCM rolling counter
+    // and CRC differ on every frame, so they are left out; the stored counter
+    // and CRC therefore only refresh when the stalk state changes.
+    static constexpr uint64_t kRightDoorChangeMask = RightDoorStatusFrame::kSignalMask;
+    static constexpr uint64_t kFrontLightingChangeMask = FrontLightingFrame::kSignalMask;
+    static constexpr uint64_t kSCCMLeftStalkChangeMask =
+        SCCMLeftStalkFrame::kSignalMask & ~CanSignal::Signal<0, 12>::kPayloadMask;
+
+    // Per-ID receive counters for the change-detection fast path.
+    struct RxStats
+    {
+        uint32_t frames = 0;    // accepted by the decoder
+        uint32_t unchanged = 0; // same masked payload as the previous frame
+    };
+
+    explicit CANManager(uint8_t csPin = PIN_CAN_CS) : _mcp(csPin) { _applyFilters(); }
+
+    // Use another transport instead of the MCP2515; call before begin().
+    void setTransport(CanTransport &transport)
+    {
+        _transport = &transport;
+        _applyFilters();
+    }
+    CanTransport &transport() { return *_transport; }
 
     bool begin(uint32_t bitrate = CAN_BAUDRATE)
     {
-        if (!_mcp.begin(bitrate))
+        if (!_transport->begin(bitrate))
             return false;
+        _bitrate = bitrate;
+        return true;
+    }
 
-        // Filter for exactly 0x103 (door status) and 0x3F5 (front lighting)
-        // All other messages are ignored on the first mask
-        if (!_mcp.setFilterMask(0, false, 0x7FF) ||
-            !_mcp.setFilter(0, false, 0x103) ||
-            !_mcp.setFilter(1, false, 0x3F5))
-        {
-            return false;
-        }
+    struct AutoBaudResult
+    {
+        uint32_t bitrate = 0;   // detected rate, 0 if none produced frames
+        uint32_t elapsedMs = 0; // total search time
+        uint8_t attempts = 0;   // candidates probed
+        uint8_t frames = 0;     // valid frames seen at the detected rate
+        uint8_t rejected = 0;   // candidates that flagged receive errors
+    };
 
-        // Filter out all messages on the second mask
-        if (!_mcp.setFilterMask(1, false, 0x7FF) ||
-            !_mcp.setFilter(2, false, 0x249) ||
-            !_mcp.setFilter(3, false, 0x000) ||
-            !_mcp.setFilter(4, false, 0x000) ||
-            !_mcp.setFilter(5, false, 0x000))
+    // Probe each rate in CAN_AUTO_BAUD_RATES with the transport's probe(),
+    // which goes from configuration straight to listen-only mode, so a wrong
+    // guess never ACKs or drives error frames onto the bus. Listen-only still
+    // hands over frames at a wrong rate that happen to parse, so a rate is
+    // taken only if it delivers CAN_AUTO_BAUD_MIN_FRAMES frames within the
+    // window and the controller flagged no receive errors (MERRF/EFLG) in
+    // it. Only that rate is brought up in normal mode (begin()) with the
+    // usual filters. Every ID counts while probing, not just the ones the deck
+    // decodes. Bounded by (number of rates) * CAN_AUTO_BAUD_WINDOW_MS. A
+    // non-zero preferred rate (e.g. the one restored from the warm-start
+    // snapshot) is tried first.
+    bool beginAutoBaud(AutoBaudResult *result = nullptr, uint32_t preferred = 0)
+    {
+        AutoBaudResult r;
+        uint32_t start = millis();
+        constexpr uint8_t kRates = sizeof(CAN_AUTO_BAUD_RATES) / sizeof(CAN_AUTO_BAUD_RATES[0]);
+        for (int8_t i = preferred ? -1 : 0; i < kRates; ++i)
         {
-            return false;
+            uint32_t rate = i < 0 ? preferred : CAN_AUTO_BAUD_RATES[i];
+            if (i >= 0 && rate == preferred)
+                continue;
+            r.attempts++;
+            if (!_transport->probe(rate))
+                continue;
+            _transport->takeErrors(); // start the window clean
+
+            uint8_t frames = 0;
+            uint32_t windowStart = millis();
+            while (millis() - windowStart < CAN_AUTO_BAUD_WINDOW_MS && frames < CAN_AUTO_BAUD_MIN_FRAMES)
+            {
+                Frame f;
+                if (_transport->receive(f))
+                    frames++;
+                else
+                    delay(1);
+            }
+            if (_transport->takeErrors())
+            {
+                r.rejected++;
+                continue;
+            }
+            if (frames >= CAN_AUTO_BAUD_MIN_FRAMES)
+            {
+                r.bitrate = rate;
+                r.frames = frames;
+                break;
+            }
         }
-
-        return true;
+        r.elapsedMs = millis() - start;
+        if (result)
+            *result = r;
+        return r.bitrate && begin(r.bitrate);
     }
 
+    uint32_t bitrate() const { return _bitrate; }
+
     void setDebugRaw(bool enabled) { _debugRaw = enabled; }
     void setDebugDecoded(bool enabled) { _debugDecoded = enabled; }
 
@@ -132,220 +227,434 @@ public:
         return c;
     }
 
+    using Frame = CanFrame;
+
+    // Frames that are not decoded here (e.g. diagnostic responses) are offered
+    // to this handler; it returns true if it consumed the frame.
+    using FrameHandler = bool (*)(const Frame &f, void *ctx);
+    void setFrameHandler(FrameHandler handler, void *ctx)
+    {
+        _frameHandler = handler;
+        _frameHandlerCtx = ctx;
+    }
+
+    // Called for every frame of a decoded ID, including the repeats that skip
+    // decoding, once the cached message (get...(false)) reflects it.
+    using SampleHandler = void (*)(uint32_t id, void *ctx);
+    void setSampleHandler(SampleHandler handler, void *ctx)
+    {
+        _sampleHandler = handler;
+        _sampleHandlerCtx = ctx;
+    }
+    SampleHandler sampleHandler() const { return _sampleHandler; }
+    void *sampleHandlerCtx() const { return _sampleHandlerCtx; }
+
+    // Extra receive IDs on the spare acceptance filters (RXF3-RXF5, mask 1).
+    static constexpr uint8_t kExtraFilters = 3;
+
+    // Accept frames with this standard ID; false when all spare filters are taken.
+    bool subscribe(uint16_t id)
+    {
+        int8_t slot = -1;
+        for (uint8_t i = 0; i < kExtraFilters; ++i)
+        {
+            bool used = _extraUsed & (1u << i);
+            if (used && _extraIds[i] == id)
+                return true;
+            if (!used && slot < 0)
+                slot = (int8_t)i;
+        }
+        if (slot < 0 || !_transport->setFilter(3 + slot, id))
+            return false;
+        _extraIds[slot] = id;
+        _extraUsed |= 1u << slot;
+        return true;
+    }
+
+    void unsubscribe(uint16_t id)
+    {
+        for (uint8_t i = 0; i < kExtraFilters; ++i)
+        {
+            if ((_extraUsed & (1u << i)) && _extraIds[i] == id)
+            {
+                _extraUsed &= ~(1u << i);
+                _transport->clearFilter(3 + i);
+            }
+        }
+    }
+
     // Poll and drain all pending frames; returns true if at least one processed.
     bool poll()
     {
         bool any = false;
-        // Drain loop: parsePacket() returns 0 when no more frames.
+        Frame f;
         while (true)
         {
-            int packetSize = _mcp.parsePacket();
-            if (!packetSize)
+            CAN_PROFILE_BEGIN(prof);
+            if (!fetchFrame(f))
+            {
+                CAN_PROFILE_LAP(prof, CanProfile::kIdle, Fetch);
                 break;
+            }
+            CAN_PROFILE_LAP(prof, f.id, Fetch);
             any = true;
+            handleFrame(f);
+        }
+        return any;
+    }
 
-            uint32_t id = _mcp.packetId();
-            bool isRtr = _mcp.packetRtr();
-            uint8_t data[8] = {0};
-            int len = 0;
-            if (!isRtr)
+    // Read one pending frame from the transport; false when it is empty.
+    bool fetchFrame(Frame &f) { return _transport->receive(f); }
+
+    // Debug output and decode for one frame. A frame whose signal bits match
+    // the previous one only refreshes lastRxMs; the "new" flag stays clear,
+    // but the sample handler still sees it.
+    void handleFrame(const Frame &f)
+    {
+        uint32_t id = f.id;
+        bool isRtr = f.rtr;
+        int len = f.len;
+        const uint8_t *data = f.data;
+
+        if (_debugRaw)
+        {
+            Serial.print(F("CAN: id=0x"));
+            Serial.print(id, HEX);
+            if (f.extended)
+                Serial.print(F(" ext"));
+            if (isRtr)
+                Serial.print(F(" RTR"));
+            Serial.print(F(" len="));
+            Serial.print(f.dlc);
+            Serial.print(F(" data="));
+            if (isRtr)
             {
-                while (_mcp.available() && len < 8)
+                Serial.print(F("<RTR>"));
+            }
+            else
+            {
+                for (int i = 0; i < len; ++i)
                 {
-                    data[len++] = _mcp.read();
+                    if (data[i] < 0x10)
+                        Serial.print('0');
+                    Serial.print(data[i], HEX);
+                    Serial.print(' ');
                 }
             }
+            Serial.println();
+        }
 
-            if (_debugRaw)
+        // Profiled from here: the debug output above is not part of the hot path.
+        CAN_PROFILE_BEGIN(prof);
+        if (_frameHandler && _frameHandler(f, _frameHandlerCtx))
+        {
+            CAN_PROFILE_LAP(prof, id, Notify);
+            return;
+        }
+
+        // Decode VCRIGHT_doorStatus (standard ID 0x103, DLC 8)
+        if (id == RightDoorStatusFrame::kId && !isRtr && len >= RightDoorStatusFrame::kMinLen)
+        { // need at least byte 4 for rearIntSwitchPressed
+            CAN_PROFILE_LAP(prof, id, Dispatch);
+            if (!_payloadChanged(data, kRightDoorChangeMask, _rightDoorRx))
             {
-                Serial.print(F("CAN: id=0x"));
-                Serial.print(id, HEX);
-                if (_mcp.packetExtended())
-                    Serial.print(F(" ext"));
-                if (isRtr)
-                    Serial.print(F(" RTR"));
-                Serial.print(F(" len="));
-                Serial.print(packetSize);
-                Serial.print(F(" data="));
-                if (isRtr)
-                {
-                    Serial.print(F("<RTR>"));
-                }
-                else
-                {
-                    for (int i = 0; i < len; ++i)
-                    {
-                        if (data[i] < 0x10)
-                            Serial.print('0');
-                        Serial.print(data[i], HEX);
-                        Serial.print(' ');
-                    }
-                }
+                _rightDoor.lastRxMs = millis();
+                CAN_PROFILE_LAP(prof, id, Change);
+                _sample(id);
+                CAN_PROFILE_LAP(prof, id, Notify);
+                return;
+            }
+            CAN_PROFILE_LAP(prof, id, Change);
+            RightDoorStatusMsg msg;
+            if (!RightDoorStatusFrame::unpack(data, msg))
+            {
+                _rightDoorRx.valid = false; // out-of-range signal: drop it, recheck the next frame
+                CAN_PROFILE_LAP(prof, id, Extract);
+                return;
+            }
+            CAN_PROFILE_LAP(prof, id, Extract);
+            msg.lastRxMs = millis();
+            _rightDoor = msg;
+            _rightDoorNew = true;
+            _sample(id);
+            CAN_PROFILE_LAP(prof, id, Notify);
+            if (_debugDecoded)
+            {
+                Serial.print(F("DoorStatus: rearIntSwitchPressed="));
+                Serial.print(msg.rearIntSwitchPressed);
                 Serial.println();
             }
+        }
 
-            // Decode VCRIGHT_doorStatus (standard ID 0x103, DLC 8)
-            if (id == 0x103 && !isRtr && len >= 5)
-            { // need at least byte 4 for rearIntSwitchPressed
-                RightDoorStatusMsg msg;
-                // Signal VCRIGHT_rearIntSwitchPressed : 32|1@1+ (little-endian) -> bit0 (LSB) of byte 4
-                msg.rearIntSwitchPressed = (data[4] & 0x01) != 0;
-                msg.lastRxMs = millis();
-                _rightDoor = msg;
-                _rightDoorNew = true;
-                if (_debugDecoded)
-                {
-                    Serial.print(F("DoorStatus: rearIntSwitchPressed="));
-                    Serial.print(msg.rearIntSwitchPressed);
-                    Serial.println();
-                }
+        // Decode VCFRONT_lighting (standard ID 0x3F5, DLC 8) - only need first byte for indicator requests
+        if (id == FrontLightingFrame::kId && !isRtr && len >= FrontLightingFrame::kMinLen)
+        {
+            CAN_PROFILE_LAP(prof, id, Dispatch);
+            if (!_payloadChanged(data, kFrontLightingChangeMask, _frontLightingRx))
+            {
+                _frontLighting.lastRxMs = millis();
+                CAN_PROFILE_LAP(prof, id, Change);
+                _sample(id);
+                CAN_PROFILE_LAP(prof, id, Notify);
+                return;
             }
-
-            // Decode VCFRONT_lighting (standard ID 0x3F5, DLC 8) - only need first byte for indicator requests
-            if (id == 0x3F5 && !isRtr && len >= 1)
+            CAN_PROFILE_LAP(prof, id, Change);
+            FrontLightingMsg msg;
+            // Left indicator: bits 0-1, right indicator: bits 2-3. Raw values map
+            // 1:1 onto IndicatorReq (3 is SNA -> Unknown).
+            if (!FrontLightingFrame::unpack(data, msg))
+            {
+                _frontLightingRx.valid = false; // out-of-range signal: drop it, recheck the next frame
+                CAN_PROFILE_LAP(prof, id, Extract);
+                return;
+            }
+            CAN_PROFILE_LAP(prof, id, Extract);
+            msg.lastRxMs = millis();
+            _frontLighting = msg;
+            _frontLightingNew = true;
+            _sample(id);
+            CAN_PROFILE_LAP(prof, id, Notify);
+            if (_debugDecoded)
             {
-                FrontLightingMsg msg;
-                // Left indicator: bits 0-1
-                uint8_t rawLeft = (uint8_t)(data[0] & 0x03);
-                switch (rawLeft)
+                Serial.print(F("FrontLighting: left="));
+                switch (msg.indicatorLeftRequest)
                 {
-                case 0:
-                    msg.indicatorLeftRequest = IndicatorReq::Off;
+                case IndicatorReq::Off:
+                    Serial.print(F("OFF"));
                     break;
-                case 1:
-                    msg.indicatorLeftRequest = IndicatorReq::ActiveLow;
+                case IndicatorReq::ActiveLow:
+                    Serial.print(F("ACTIVE_LOW"));
                     break;
-                case 2:
-                    msg.indicatorLeftRequest = IndicatorReq::ActiveHigh;
+                case IndicatorReq::ActiveHigh:
+                    Serial.print(F("ACTIVE_HIGH"));
                     break;
-                default:
-                    msg.indicatorLeftRequest = IndicatorReq::Unknown;
+                case IndicatorReq::Unknown:
+                    Serial.print(F("UNKNOWN"));
                     break;
                 }
-                // Right indicator: bits 2-3
-                uint8_t rawRight = (uint8_t)((data[0] >> 2) & 0x03);
-                switch (rawRight)
+                Serial.print(F(" right="));
+                switch (msg.indicatorRightRequest)
                 {
-                case 0:
-                    msg.indicatorRightRequest = IndicatorReq::Off;
+                case IndicatorReq::Off:
+                    Serial.println(F("OFF"));
                     break;
-                case 1:
-                    msg.indicatorRightRequest = IndicatorReq::ActiveLow;
+                case IndicatorReq::ActiveLow:
+                    Serial.println(F("ACTIVE_LOW"));
                     break;
-                case 2:
-                    msg.indicatorRightRequest = IndicatorReq::ActiveHigh;
+                case IndicatorReq::ActiveHigh:
+                    Serial.println(F("ACTIVE_HIGH"));
                     break;
-                default:
-                    msg.indicatorRightRequest = IndicatorReq::Unknown;
+                case IndicatorReq::Unknown:
+                    Serial.println(F("UNKNOWN"));
                     break;
                 }
-                msg.lastRxMs = millis();
-                _frontLighting = msg;
-                _frontLightingNew = true;
-                if (_debugDecoded)
-                {
-                    Serial.print(F("FrontLighting: left="));
-                    switch (msg.indicatorLeftRequest)
-                    {
-                    case IndicatorReq::Off:
-                        Serial.print(F("OFF"));
-                        break;
-                    case IndicatorReq::ActiveLow:
-                        Serial.print(F("ACTIVE_LOW"));
-                        break;
-                    case IndicatorReq::ActiveHigh:
-                        Serial.print(F("ACTIVE_HIGH"));
-                        break;
-                    case IndicatorReq::Unknown:
-                        Serial.print(F("UNKNOWN"));
-                        break;
-                    }
-                    Serial.print(F(" right="));
-                    switch (msg.indicatorRightRequest)
-                    {
-                    case IndicatorReq::Off:
-                        Serial.println(F("OFF"));
-                        break;
-                    case IndicatorReq::ActiveLow:
-                        Serial.println(F("ACTIVE_LOW"));
-                        break;
-                    case IndicatorReq::ActiveHigh:
-                        Serial.println(F("ACTIVE_HIGH"));
-                        break;
-                    case IndicatorReq::Unknown:
-                        Serial.println(F("UNKNOWN"));
-                        break;
-                    }
-                }
             }
+        }
 
-            // Decode ID249SCCMLeftStalk (standard ID 0x249, DLC 4)
-            if (id == 0x249 && !isRtr && len >= 3)
+        // Decode ID249SCCMLeftStalk (standard ID 0x249, DLC 4)
+        if (id == SCCMLeftStalkFrame::kId && !isRtr && len >= SCCMLeftStalkFrame::kMinLen)
+        {
+            CAN_PROFILE_LAP(prof, id, Dispatch);
+            if (!_payloadChanged(data, kSCCMLeftStalkChangeMask, _sccmLeftStalkRx))
             {
-                SCCMLeftStalkMsg msg;
-                msg.leftStalkCrc = data[0];
-                msg.leftStalkCounter = (data[1] >> 0) & 0x0F;
-                msg.highBeamStalkStatus = (HighBeamStalkStatus)((data[1] >> 4) & 0x03);
-                msg.washWipeButtonStatus = (WashWipeButtonStatus)((data[1] >> 6) & 0x03);
-                msg.turnIndicatorStalkStatus = (TurnIndicatorStalkStatus)((data[2] >> 0) & 0x07);
-                msg.lastRxMs = millis();
-                _sccmLeftStalk = msg;
-                _sccmLeftStalkNew = true;
-                if (_debugDecoded)
-                {
-                    Serial.print(F("SCCMLeftStalk: highBeam="));
-                    Serial.print((uint8_t)msg.highBeamStalkStatus);
-                    Serial.print(F(" turn="));
-                    Serial.print((uint8_t)msg.turnIndicatorStalkStatus);
-                    Serial.print(F(" washWipe="));
-                    Serial.print((uint8_t)msg.washWipeButtonStatus);
-                    Serial.print(F(" counter="));
-                    Serial.print(msg.leftStalkCounter);
-                    Serial.print(F(" crc="));
-                    Serial.print(msg.leftStalkCrc, HEX);
-                    Serial.println();
-                }
+                _sccmLeftStalk.lastRxMs = millis();
+                CAN_PROFILE_LAP(prof, id, Change);
+                _sample(id);
+                CAN_PROFILE_LAP(prof, id, Notify);
+                return;
+            }
+            CAN_PROFILE_LAP(prof, id, Change);
+            SCCMLeftStalkMsg msg;
+            if (!SCCMLeftStalkFrame::unpack(data, msg))
+            {
+                _sccmLeftStalkRx.valid = false; // out-of-range signal: drop it, recheck the next frame
+                CAN_PROFILE_LAP(prof, id, Extract);
+                return;
+            }
+            CAN_PROFILE_LAP(prof, id, Extract);
+            msg.lastRxMs = millis();
+            _sccmLeftStalk = msg;
+            _sccmLeftStalkNew = true;
+            _sample(id);
+            CAN_PROFILE_LAP(prof, id, Notify);
+            if (_debugDecoded)
+            {
+                Serial.print(F("SCCMLeftStalk: highBeam="));
+                Serial.print((uint8_t)msg.highBeamStalkStatus);
+                Serial.print(F(" turn="));
+                Serial.print((uint8_t)msg.turnIndicatorStalkStatus);
+                Serial.print(F(" washWipe="));
+                Serial.print((uint8_t)msg.washWipeButtonStatus);
+                Serial.print(F(" counter="));
+                Serial.print(msg.leftStalkCounter);
+                Serial.print(F(" crc="));
+                Serial.print(msg.leftStalkCrc, HEX);
+                Serial.println();
             }
         }
-        return any;
     }
 
-
     void sendTurnSignalCommand(TurnIndicatorStalkStatus turnStatus,
                                HighBeamStalkStatus highBeamStatus = HighBeamStalkStatus::Idle,
                                WashWipeButtonStatus washWipeStatus = WashWipeButtonStatus::NotPressed,
                                uint8_t reserved = 0)
     {
-        // ID 0x249, DLC 3, Motorola (big-endian) bit layout
+        // ID 0x249, DLC 3, Intel (little-endian) bit layout, see SCCMLeftStalkFrame
         // Byte 0: CRC (placeholder, set to 0)
-        // Byte 1: [counter(7:4)] [highBeam(3:2)] [washWipe(1:0)]
-        // Byte 2: [turnStatus(7:5)] [reserved(4:0)]
+        // Byte 1: [washWipe(7:6)] [highBeam(5:4)] [counter(3:0)]
+        // Byte 2: [reserved(7:3)] [turnStatus(2:0)]
 
         static uint8_t counter = 0;
-        uint8_t data[3] = {0};
+        SCCMLeftStalkMsg msg;
+        msg.leftStalkCrc = 0; // CRC (unknown polynomial, set to 0 for now)
+        msg.leftStalkCounter = counter;
+        msg.highBeamStalkStatus = highBeamStatus;
+        msg.washWipeButtonStatus = washWipeStatus;
+        msg.turnIndicatorStalkStatus = turnStatus;
+        msg.reserved = reserved;
+        sendSCCMLeftStalk(msg);
 
-        // Byte 1
-        data[1] = ((counter & 0x0F) << 4) |
-                  (((uint8_t)highBeamStatus & 0x03) << 2) |
-                  ((uint8_t)washWipeStatus & 0x03);
+        counter = (counter + 1) % 16;
+    }
 
-        // Byte 2
-        data[2] = (((uint8_t)turnStatus & 0x07) << 5) |
-                  (reserved & 0x1F);
+    bool sendSCCMLeftStalk(const SCCMLeftStalkMsg &msg)
+    {
+        uint8_t data[8];
+        if (!SCCMLeftStalkFrame::pack(msg, data))
+            return false; // e.g. a turn status past SNA
+        return sendFrame(SCCMLeftStalkFrame::kId, data, SCCMLeftStalkFrame::kDlc);
+    }
 
-        // Byte 0: CRC (unknown polynomial, set to 0 for now)
-        data[0] = 0;
+    bool sendFrame(uint16_t id, const uint8_t *data, uint8_t len)
+    {
+        // Rules may fire while warm-start state is applied, before begin().
+        if (!_bitrate)
+            return false;
+        CAN_PROFILE_BEGIN(prof);
+        bool ok = _transport->send(id, data, len);
+        CAN_PROFILE_LAP(prof, id, Tx);
+        return ok;
+    }
 
-        _mcp.beginPacket(0x249);
-        _mcp.write(data, 3);
-        _mcp.endPacket();
+    // Internal loopback: transmitted frames are received by this controller
+    // only and never reach the bus. begin() returns to normal mode.
+    bool enterLoopback() { return _transport->loopback(); }
 
-        counter = (counter + 1) % 16;
+    const RxStats &rightDoorRxStats() const { return _rightDoorRx.stats; }
+    const RxStats &frontLightingRxStats() const { return _frontLightingRx.stats; }
+    const RxStats &sccmLeftStalkRxStats() const { return _sccmLeftStalkRx.stats; }
+
+    void printRxStats(Print &out) const
+    {
+        out.println(F("ID     frames  unchanged  skip%"));
+        _printRxStats(out, RightDoorStatusFrame::kId, _rightDoorRx.stats);
+        _printRxStats(out, FrontLightingFrame::kId, _frontLightingRx.stats);
+        _printRxStats(out, SCCMLeftStalkFrame::kId, _sccmLeftStalkRx.stats);
+    }
+
+    // All decoded IDs' counters together, so a self-test can put them back.
+    struct RxStatsSet
+    {
+        RxStats rightDoor;
+        RxStats frontLighting;
+        RxStats sccmLeftStalk;
+    };
+    RxStatsSet rxStats() const { return {_rightDoorRx.stats, _frontLightingRx.stats, _sccmLeftStalkRx.stats}; }
+    void setRxStats(const RxStatsSet &s)
+    {
+        _rightDoorRx.stats = s.rightDoor;
+        _frontLightingRx.stats = s.frontLighting;
+        _sccmLeftStalkRx.stats = s.sccmLeftStalk;
+    }
+
+    void resetRxStats()
+    {
+        _rightDoorRx.stats = RxStats{};
+        _frontLightingRx.stats = RxStats{};
+        _sccmLeftStalkRx.stats = RxStats{};
+    }
+
+    // Drop all decoded state and pending "new" flags (e.g. after a self-test
+    // pushed synthetic frames through the decoder).
+    void resetDecoded()
+    {
+        _rightDoorRx.valid = false;
+        _frontLightingRx.valid = false;
+        _sccmLeftStalkRx.valid = false;
+        _rightDoor = RightDoorStatusMsg{};
+        _rightDoorNew = false;
+        _frontLighting = FrontLightingMsg{};
+        _frontLightingNew = false;
+        _sccmLeftStalk = SCCMLeftStalkMsg{};
+        _sccmLeftStalkNew = false;
     }
 
-    Adafruit_MCP2515 &mcp() { return _mcp; }
+    bool debugRaw() const { return _debugRaw; }
+    bool debugDecoded() const { return _debugDecoded; }
 
 private:
+    struct RxCache
+    {
+        uint64_t masked = 0; // signal bits of the last decoded payload
+        bool valid = false;
+        RxStats stats;
+    };
+
+    // Compares the signal bits as one little-endian word; false means the
+    // decode can be skipped.
+    static bool _payloadChanged(const uint8_t *data, uint64_t mask, RxCache &c)
+    {
+        uint64_t masked = CanSignal::loadLE(data) & mask;
+        c.stats.frames++;
+        if (c.valid && masked == c.masked)
+        {
+            c.stats.unchanged++;
+            return false;
+        }
+        c.masked = masked;
+        c.valid = true;
+        return true;
+    }
+
+    static void _printRxStats(Print &out, uint16_t id, const RxStats &s)
+    {
+        out.print(F("0x"));
+        out.print(id, HEX);
+        out.print(F("  "));
+        out.print(s.frames);
+        out.print(F("  "));
+        out.print(s.unchanged);
+        out.print(F("  "));
+        out.println(s.frames ? (uint32_t)((uint64_t)s.unchanged * 100 / s.frames) : 0);
+    }
+
+    void _sample(uint32_t id)
+    {
+        if (_sampleHandler)
+            _sampleHandler(id, _sampleHandlerCtx);
+    }
+
+    bool _applyFilters()
+    {
+        // Exactly 0x103 (door status), 0x3F5 (front lighting) and 0x249 (SCCM
+        // left stalk), then any subscribed IDs; everything else is ignored.
+        if (!_transport->setFilter(0, RightDoorStatusFrame::kId) ||
+            !_transport->setFilter(1, FrontLightingFrame::kId) ||
+            !_transport->setFilter(2, SCCMLeftStalkFrame::kId))
+        {
+            return false;
+        }
+        for (uint8_t i = 0; i < kExtraFilters; ++i)
+        {
+            bool ok = (_extraUsed & (1u << i)) ? _transport->setFilter(3 + i, _extraIds[i])
+                                               : _transport->clearFilter(3 + i);
+            if (!ok)
+                return false;
+        }
+
+        return true;
+    }
+
     // CRC computation for stalk messages (ID 0x249, 0x24A).
     // It's a CRC-8 with polynomial 0x1D (AUTOSAR), initial value 0xFF, final XOR 0xFF.
     // The CRC is calculated over bytes 1 and 2 of the CAN frame (after packing all fields).
@@ -370,7 +679,9 @@ private:
         return crc ^ 0xFF;
     }
 
-    Adafruit_MCP2515 _mcp;
+    Mcp2515Transport _mcp;
+    CanTransport *_transport = &_mcp;
+    uint32_t _bitrate = 0;
     bool _debugRaw = false;
     bool _debugDecoded = true; // default show decoded message when present
     RightDoorStatusMsg _rightDoor{};
@@ -379,4 +690,13 @@ private:
     bool _frontLightingNew = false;
     SCCMLeftStalkMsg _sccmLeftStalk{};
     bool _sccmLeftStalkNew = false;
+    FrameHandler _frameHandler = nullptr;
+    void *_frameHandlerCtx = nullptr;
+    SampleHandler _sampleHandler = nullptr;
+    void *_sampleHandlerCtx = nullptr;
+    uint16_t _extraIds[kExtraFilters] = {0, 0, 0};
+    uint8_t _extraUsed = 0; // bit i: _extraIds[i] is subscribed
+    RxCache _rightDoorRx;
+    RxCache _frontLightingRx;
+    RxCache _sccmLeftStalkRx;
 };
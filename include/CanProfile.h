@@ -0,0 +1,84 @@
+// Optional per-ID cost counters for the CAN hot path, enabled by building
+// with -DCAN_PROFILE. Each stage of receiving a frame (and the TX path) is
+// timed and folded into running min/avg/max per CAN ID in a static table.
+//
+// Units are CPU cycles from SysTick on the RP2040 and nanoseconds from
+// steady_clock elsewhere (the host simulator, which measures the host, not
+// the board). Without CAN_PROFILE the macros below expand to nothing.
+#pragma once
+
+#ifdef CAN_PROFILE
+
+#include <Arduino.h>
+#include <stdint.h>
+
+#if defined(ARDUINO_ARCH_RP2040)
+#include <hardware/structs/systick.h>
+#else
+#include <chrono>
+#endif
+
+namespace CanProfile
+{
+    enum Stage : uint8_t
+    {
+        Fetch,    // reading the frame from the controller (SPI on the MCP2515)
+        Dispatch, // matching the ID to a decoder or the frame handler
+        Change,   // masked payload comparison
+        Extract,  // unpacking signals
+        Notify,   // storing the message and the sample consumer (history, rules,
+                  // warm start), or the frame handler
+        Tx,       // handing a frame to the controller
+        kStages
+    };
+
+    static constexpr uint8_t kMaxIds = 16;
+    static constexpr uint32_t kIdle = 0xFFFFFFFF; // poll() that found nothing
+
+    // Starts the timer where needed; call once at boot.
+    void begin();
+
+#if defined(ARDUINO_ARCH_RP2040)
+    // SysTick counts down at the CPU clock from its reload value: 0xFFFFFF
+    // when begin() starts it, whatever an RTOS chose if it already runs (laps
+    // longer than one period then alias).
+    extern uint32_t g_reload;
+    inline uint32_t now() { return systick_hw->cvr; }
+    inline uint32_t elapsed(uint32_t start, uint32_t end)
+    {
+        return start >= end ? start - end : start + (g_reload + 1) - end;
+    }
+#else
+    inline uint32_t now()
+    {
+        return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+    inline uint32_t elapsed(uint32_t start, uint32_t end) { return end - start; }
+#endif
+
+    void record(uint32_t id, Stage stage, uint32_t ticks);
+
+    inline void lap(uint32_t &t, uint32_t id, Stage stage)
+    {
+        record(id, stage, elapsed(t, now()));
+        t = now();
+    }
+
+    void print(Print &out);
+    void reset();
+}
+
+// Start a stage timer in a local variable.
+#define CAN_PROFILE_BEGIN(t) uint32_t t = CanProfile::now()
+// Charge the time since the last BEGIN/LAP to (id, stage) and restart the
+// timer; the bookkeeping itself is not counted.
+#define CAN_PROFILE_LAP(t, id, stage) CanProfile::lap(t, (id), CanProfile::stage)
+
+#else
+
+#define CAN_PROFILE_BEGIN(t)
+#define CAN_PROFILE_LAP(t, id, stage) ((void)0)
+
+#endif
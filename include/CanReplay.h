@@ -0,0 +1,124 @@
+// Plays a recorded CAN trace from LittleFS back onto the bus with its
+// original inter-frame timing. Traces are either candump logs
+// ("(sec.usec) iface ID#DATA" lines) or the compact binary format written by
+// convertCandump(). Frames stream from flash through a small prefetch ring
+// so service() never blocks on file I/O for more than a few records.
+//
+// Compact format: "OCR1" then one record per frame:
+//   varint  delta_us since the previous frame (LEB128)
+//   uint8   rtr(7) | dlc(6:3) | id(10:8)
+//   uint8   id(7:0)
+//   uint8[] data (dlc bytes, absent for RTR)
+#pragma once
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "CANManager.h"
+
+class CanReplay
+{
+public:
+    static constexpr uint8_t kPrefetch = 32;        // frames buffered ahead of playback
+    static constexpr uint8_t kRefillPerService = 8; // max records read per service()
+    static constexpr uint8_t kMaxIdFilters = 8;
+    static constexpr uint32_t kSingleFrameLoopUs = 100000; // loop period of a one-frame trace
+
+    enum class FilterMode : uint8_t
+    {
+        None,
+        Include, // only the listed IDs are sent
+        Exclude  // the listed IDs are dropped
+    };
+
+    struct Stats
+    {
+        uint32_t sent = 0;
+        uint32_t filtered = 0; // dropped by the ID filter
+        uint32_t skipped = 0;  // extended/RTR/unparseable records
+        uint32_t failed = 0;   // TX refused by the controller
+        uint16_t loops = 0;
+        // Lateness of each transmission against the scaled trace timestamp.
+        uint64_t errTotalUs = 0;
+        uint32_t errMaxUs = 0;
+    };
+
+    explicit CanReplay(CANManager &can) : _can(can) {}
+
+    // speedPercent scales playback rate: 100 = original timing, 200 = twice
+    // as fast. Returns false if the file cannot be opened.
+    bool start(const char *path, uint16_t speedPercent = 100, bool loop = false);
+    void stop();
+    bool active() const { return _active; }
+
+    // Non-blocking; call every loop iteration.
+    void service();
+
+    void setIdFilter(FilterMode mode, const uint16_t *ids, uint8_t count);
+
+    const Stats &stats() const { return _stats; }
+    void printStats(Print &out) const;
+
+    // Convert a candump log on LittleFS into the compact format.
+    static bool convertCandump(const char *inPath, const char *outPath, uint32_t *frames = nullptr);
+
+private:
+    struct Entry
+    {
+        uint64_t traceUs; // relative to the start of playback (includes loops)
+        uint16_t id;
+        uint8_t dlc;
+        uint8_t data[8];
+    };
+
+    enum class ReadResult : uint8_t
+    {
+        Frame,
+        Skip,
+        End
+    };
+
+    void _refill();
+    bool _rewind();
+    ReadResult _readRecord(Entry &e);
+    ReadResult _readBinary(Entry &e);
+    ReadResult _readText(Entry &e);
+    bool _passes(uint16_t id) const;
+
+    int _readByte();
+    static bool _parseCandumpLine(char *line, uint64_t &tsUs, uint32_t &id, bool &ext, bool &rtr, uint8_t &dlc, uint8_t *data);
+
+    CANManager &_can;
+    File _file;
+    bool _active = false;
+    bool _binary = false;
+    bool _loop = false;
+    bool _eof = false;
+    uint16_t _speedPercent = 100;
+    uint32_t _startUs = 0;
+
+    // Trace time bookkeeping
+    uint64_t _passUs = 0;      // time of the last record relative to the start of this pass
+    uint64_t _lastUs = 0;      // playback time of the last record read
+    uint64_t _loopBaseUs = 0;  // added to every record after a wrap
+    uint64_t _originUs = 0;    // first candump timestamp of the pass
+    bool _haveOrigin = false;
+    uint32_t _passFrames = 0;  // frames read in the current pass
+    uint32_t _passQueued = 0;  // of those, frames that passed the ID filter
+    uint64_t _passFirstUs = 0; // pass-relative time of the first frame
+    uint64_t _loopGapUs = 0;   // first inter-frame gap, repeated at the loop wrap
+
+    // Read buffer over the file
+    uint8_t _buf[128];
+    uint8_t _bufLen = 0;
+    uint8_t _bufPos = 0;
+
+    Entry _ring[kPrefetch];
+    uint8_t _head = 0;
+    uint8_t _count = 0;
+
+    FilterMode _filterMode = FilterMode::None;
+    uint16_t _filterIds[kMaxIdFilters];
+    uint8_t _filterCount = 0;
+
+    Stats _stats;
+};
@@ -0,0 +1,183 @@
+// Compile-time CAN signal descriptors. A Message lists the Fields of a frame
+// (struct member, DBC start bit, length, byte order, value range) and
+// generates mask-and-shift pack()/unpack() code for it. Layout errors
+// (signals past the DLC, overlapping signals, ranges that don't fit the field
+// width) are rejected by static_assert; values outside a field's range make
+// pack()/unpack() return false. The range check is only generated where it
+// can fail: for unpack() when the range is narrower than the field width, for
+// pack() when it is narrower than the struct member's type. Everything else
+// is branch-free.
+#pragma once
+
+#include <limits>
+#include <stdint.h>
+#include <type_traits>
+
+namespace CanSignal
+{
+    enum class ByteOrder : uint8_t
+    {
+        Intel,   // @1: little-endian, start bit is the LSB
+        Motorola // @0: big-endian, start bit is the MSB (DBC sawtooth numbering)
+    };
+
+    // Payload bytes as 64-bit words. Intel signals are contiguous in the
+    // little-endian word, Motorola signals in the big-endian one.
+    constexpr uint64_t loadLE(const uint8_t *d)
+    {
+        return (uint64_t)d[0] | ((uint64_t)d[1] << 8) | ((uint64_t)d[2] << 16) | ((uint64_t)d[3] << 24) |
+               ((uint64_t)d[4] << 32) | ((uint64_t)d[5] << 40) | ((uint64_t)d[6] << 48) | ((uint64_t)d[7] << 56);
+    }
+
+    constexpr uint64_t bswap64(uint64_t w)
+    {
+        return ((w & 0x00000000000000FFull) << 56) | ((w & 0x000000000000FF00ull) << 40) |
+               ((w & 0x0000000000FF0000ull) << 24) | ((w & 0x00000000FF000000ull) << 8) |
+               ((w & 0x000000FF00000000ull) >> 8) | ((w & 0x0000FF0000000000ull) >> 24) |
+               ((w & 0x00FF000000000000ull) >> 40) | ((w & 0xFF00000000000000ull) >> 56);
+    }
+
+    constexpr void storeLE(uint8_t *d, uint64_t w)
+    {
+        for (uint8_t i = 0; i < 8; ++i)
+            d[i] = (uint8_t)(w >> (8 * i));
+    }
+
+    constexpr uint8_t popcount64(uint64_t w)
+    {
+        uint8_t n = 0;
+        for (; w; w &= w - 1)
+            ++n;
+        return n;
+    }
+
+    // Whether a value of type T can lie outside [Min, Max].
+    template <typename T, uint32_t Min, uint32_t Max>
+    constexpr bool canExceed()
+    {
+        if constexpr (std::is_enum_v<T>)
+            return canExceed<std::underlying_type_t<T>, Min, Max>();
+        else if constexpr (std::is_same_v<T, bool>)
+            return Min > 0 || Max < 1;
+        else
+            return std::is_signed_v<T> || Min > 0 || Max < std::numeric_limits<T>::max();
+    }
+
+    // A single signal: position and width inside the 8-byte payload.
+    template <uint8_t StartBit, uint8_t Length, ByteOrder Order = ByteOrder::Intel,
+              uint32_t Min = 0, uint32_t Max = (uint32_t)((1ull << Length) - 1)>
+    struct Signal
+    {
+        static_assert(Length >= 1 && Length <= 32, "signal length must be 1..32 bits");
+        static_assert(StartBit < 64, "start bit outside an 8-byte payload");
+        static_assert(Min <= Max, "signal range is empty");
+        static_assert(Max <= (uint32_t)((1ull << Length) - 1), "signal range does not fit the field width");
+
+        static constexpr ByteOrder kOrder = Order;
+        static constexpr uint32_t kMin = Min;
+        static constexpr uint32_t kMax = Max;
+        static constexpr uint64_t kValueMask = (1ull << Length) - 1;
+
+        // Position of the LSB in the word for this byte order. For Motorola the
+        // DBC start bit (byte*8 + bit) is the MSB; in the big-endian word byte 0
+        // occupies bits 56..63.
+        static constexpr int kMsbBE = (7 - StartBit / 8) * 8 + StartBit % 8;
+        static_assert(Order == ByteOrder::Intel || kMsbBE >= Length - 1,
+                      "Motorola signal runs past the end of the payload");
+        static constexpr uint8_t kShift = Order == ByteOrder::Intel ? StartBit : (uint8_t)(kMsbBE - (Length - 1));
+        static_assert(kShift + Length <= 64, "signal runs past the end of the payload");
+
+        static constexpr uint64_t kMask = kValueMask << kShift; // in this signal's word order
+        // Mask of the payload bits this signal occupies, as a little-endian word.
+        static constexpr uint64_t kPayloadMask = Order == ByteOrder::Intel ? kMask : bswap64(kMask);
+
+        static constexpr uint64_t place(uint32_t raw) { return ((uint64_t)raw & kValueMask) << kShift; }
+        static constexpr uint32_t extract(uint64_t word) { return (uint32_t)((word >> kShift) & kValueMask); }
+        static constexpr bool inRange(uint32_t raw) { return raw >= Min && raw <= Max; }
+        // False for full-width ranges: every extracted value is in range.
+        static constexpr bool kRawChecked = Min > 0 || Max < kValueMask;
+    };
+
+    // A signal bound to a member of the decoded message struct.
+    template <auto Member, uint8_t StartBit, uint8_t Length, ByteOrder Order = ByteOrder::Intel,
+              uint32_t Min = 0, uint32_t Max = (uint32_t)((1ull << Length) - 1)>
+    struct Field : Signal<StartBit, Length, Order, Min, Max>
+    {
+        using Base = Signal<StartBit, Length, Order, Min, Max>;
+
+        template <ByteOrder O, typename Msg>
+        static constexpr uint64_t placeFrom(const Msg &m)
+        {
+            if constexpr (O == Order)
+                return Base::place((uint32_t)(m.*Member));
+            else
+                return 0;
+        }
+
+        template <typename Msg>
+        static constexpr bool valid(const Msg &m)
+        {
+            using T = std::remove_cv_t<std::remove_reference_t<decltype(m.*Member)>>;
+            if constexpr (canExceed<T, Min, Max>())
+                return Base::inRange((uint32_t)(m.*Member));
+            else
+                return true;
+        }
+
+        // Stores the raw value even when it is out of range; the return value
+        // says whether it was in range.
+        template <typename Msg>
+        static constexpr bool assign(Msg &m, uint64_t le, uint64_t be)
+        {
+            using T = std::remove_reference_t<decltype(m.*Member)>;
+            uint32_t raw = Base::extract(Order == ByteOrder::Intel ? le : be);
+            m.*Member = static_cast<T>(raw);
+            if constexpr (Base::kRawChecked)
+                return Base::inRange(raw);
+            else
+                return true;
+        }
+    };
+
+    template <uint16_t Id, uint8_t Dlc, typename... Fields>
+    struct Message
+    {
+        static_assert(Id <= 0x7FF, "standard 11-bit identifiers only");
+        static_assert(Dlc >= 1 && Dlc <= 8, "DLC must be 1..8");
+        static_assert(sizeof...(Fields) > 0, "message has no fields");
+
+        static constexpr uint16_t kId = Id;
+        static constexpr uint8_t kDlc = Dlc;
+        // Payload bits covered by any field (little-endian word). Bits outside
+        // this mask carry nothing the firmware decodes.
+        static constexpr uint64_t kSignalMask = (Fields::kPayloadMask | ...);
+        // Shortest payload that still contains every field.
+        static constexpr uint8_t kMinLen = (uint8_t)((63 - __builtin_clzll(kSignalMask)) / 8 + 1);
+
+        static_assert(kMinLen <= Dlc, "a field lies outside the message DLC");
+        static_assert(popcount64(kSignalMask) == (popcount64(Fields::kPayloadMask) + ...), "fields overlap");
+
+        // data must hold 8 bytes; bytes past the DLC are written as zero.
+        // False, with data untouched, if any field is outside its range.
+        template <typename Msg>
+        static constexpr bool pack(const Msg &m, uint8_t *data)
+        {
+            if (!(Fields::valid(m) && ...))
+                return false;
+            uint64_t le = (Fields::template placeFrom<ByteOrder::Intel>(m) | ...);
+            uint64_t be = (Fields::template placeFrom<ByteOrder::Motorola>(m) | ...);
+            storeLE(data, le | bswap64(be));
+            return true;
+        }
+
+        // data must hold 8 bytes (zero-padded past the received length).
+        // Every field is assigned; false if any of them is outside its range.
+        template <typename Msg>
+        static constexpr bool unpack(const uint8_t *data, Msg &m)
+        {
+            uint64_t le = loadLE(data);
+            uint64_t be = bswap64(le);
+            return (Fields::assign(m, le, be) & ...);
+        }
+    };
+}
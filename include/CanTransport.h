@@ -0,0 +1,55 @@
+// Link between CANManager and the CAN controller. CANManager does all
+// decoding, filtering policy and TX packing; a transport only moves frames
+// and programs acceptance filters. Mcp2515Transport drives the Feather's
+// MCP2515; SocketCanTransport runs the same logic on a Linux CAN interface.
+#pragma once
+
+#include <Arduino.h>
+#include <stdint.h>
+
+// A received frame as read from the controller.
+struct CanFrame
+{
+    uint32_t id = 0;
+    bool extended = false;
+    bool rtr = false;
+    uint8_t dlc = 0;          // DLC as reported by the controller
+    uint8_t len = 0;          // data bytes actually read (0 for RTR)
+    uint8_t data[8] = {0};    // zero-padded past len
+    uint64_t timestampUs = 0; // receive time from the transport, 0 if it has none
+};
+
+class CanTransport
+{
+public:
+    // Exact-match standard ID filters; slot numbering follows the MCP2515
+    // (RXF0-RXF5) so CANManager can keep fixed IDs in fixed slots.
+    static constexpr uint8_t kFilterSlots = 6;
+
+    virtual ~CanTransport() = default;
+
+    // (Re)start in normal mode. Previously set filters stay in effect.
+    virtual bool begin(uint32_t bitrate) = 0;
+    // Bitrate probing: come up at this rate in listen-only mode, accepting
+    // every standard ID, without passing through normal mode, so a wrong
+    // rate never ACKs or drives error frames. begin() returns to normal with
+    // the filters. False if unsupported.
+    virtual bool probe(uint32_t bitrate) = 0;
+    // Transmitted frames come back as received ones; begin() returns to normal.
+    virtual bool loopback() = 0;
+
+    // Accept standard frames with this ID (0x000 included) in the given slot.
+    virtual bool setFilter(uint8_t slot, uint16_t id) = 0;
+    // Stop accepting frames through this slot.
+    virtual bool clearFilter(uint8_t slot) = 0;
+    // Whether the controller flagged receive errors since the last call, and
+    // clear them (bitrate probing). False if the transport cannot tell.
+    virtual bool takeErrors() = 0;
+
+    // One pending frame; false when nothing is waiting. Never blocks.
+    virtual bool receive(CanFrame &f) = 0;
+    // Queue a standard data frame; false if the controller refused it.
+    virtual bool send(uint16_t id, const uint8_t *data, uint8_t len) = 0;
+
+    virtual void printStats(Print &out) const { (void)out; }
+};
@@ -4,7 +4,9 @@
 #include <stdint.h>
 
 // I2C addresses (default Adafruit breakout values)
-constexpr uint8_t NEOKEY_I2C_ADDR = 0x30;  // NeoKey 1x4
+// NeoKey 1x4 boards in key order; chained boards need their address jumpers
+// set (0x31, 0x32, ...). Up to 8 boards / 32 keys.
+constexpr uint8_t NEOKEY_I2C_ADDRS[] = {0x30};
 constexpr uint8_t ENCODER_I2C_ADDR = 0x36; // Rotary encoder w/ NeoPixel (seesaw)
 
 // Encoder seesaw pin assignments
@@ -13,6 +15,13 @@ constexpr uint8_t ENCODER_PIXEL_PIN = 6;   // NeoPixel data pin on encoder board
 
 // Pixel brightness levels
 constexpr uint8_t ENCODER_PIXEL_BRIGHTNESS = 20; // range 0-255
+constexpr uint8_t STATUS_LED_BRIGHTNESS = 32;
+
+// Board status NeoPixel. Extra WS2812 pixels chained after it on the data pin
+// (up to StatusLED::kMaxPixels in total) can be used as a status bar.
+constexpr uint8_t STATUS_LED_POWER_PIN = 20;
+constexpr uint8_t STATUS_LED_DATA_PIN = 21;
+constexpr uint8_t STATUS_LED_PIXELS = 1;
 
 // Timing
 
@@ -22,3 +31,38 @@ constexpr uint16_t ENCODER_SCAN_INTERVAL_MS = 10; // Fast enough for quick spins
 
 // CAN bus configuration
 constexpr uint32_t CAN_BAUDRATE = 500000; // bits per second
+
+// Bitrate auto-detection (listen-only probe). Off at boot by default: on a
+// quiet bus it costs the number of rates times the window on every start, so
+// the deck comes up at the warm-start rate or CAN_BAUDRATE and "baud auto"
+// runs the search on demand. Rates are tried in order (the warm-start rate
+// first), so put the expected vehicle rate first.
+constexpr bool CAN_AUTO_BAUD = false;
+constexpr uint32_t CAN_AUTO_BAUD_RATES[] = {500000, 250000, 125000, 1000000};
+constexpr uint16_t CAN_AUTO_BAUD_WINDOW_MS = 150; // per candidate rate
+constexpr uint8_t CAN_AUTO_BAUD_MIN_FRAMES = 2;   // valid frames needed to accept a rate
+
+// Loopback self-test: hold this key chord (NeoKey bit mask) or send "bench".
+constexpr uint32_t BENCH_KEY_CHORD = 0x03; // keys 0 + 1
+constexpr uint16_t CAN_BENCH_FRAMES = 1000;
+
+// Signal-to-LED/action rules, compiled at boot from LittleFS. Built-in
+// defaults are used when the file is missing.
+constexpr const char *RULES_PATH = "/rules.txt";
+
+// Warm start: the last decoded state of these signals (bit per SignalId)
+// plus bitrate, rule source and replay filter are snapshotted to LittleFS
+// and restored at boot before CAN comes up. The stalk signals are momentary
+// and left out.
+constexpr const char *const WARM_START_PATHS[2] = {"/warm_a.bin", "/warm_b.bin"};
+constexpr uint32_t WARM_START_SIGNALS = 0x07;           // indicatorLeft/Right, rearIntSwitch
+constexpr uint16_t WARM_START_SETTLE_MS = 2000;         // state must hold this long
+constexpr uint32_t WARM_START_MIN_INTERVAL_MS = 60000;  // at most one flash write per minute
+constexpr uint32_t WARM_START_STALE_MS = 10000;         // restored state unconfirmed this long is dropped
+
+// Diagnostics (UDS over ISO-TP). Responses come from request ID + offset
+// (0x7E0 -> 0x7E8). The flow control we send lets the ECU stream without
+// overrunning the MCP2515's two receive buffers between polls.
+constexpr uint16_t UDS_RESPONSE_ID_OFFSET = 8;
+constexpr uint8_t ISOTP_RX_BLOCK_SIZE = 0; // 0 = no further flow control frames
+constexpr uint8_t ISOTP_RX_STMIN_MS = 1;
@@ -0,0 +1,101 @@
+// ISO 15765-2 (ISO-TP) transport over CANManager, normal 11-bit addressing.
+// Each session pairs a TX and an RX ID and owns a static buffer that holds
+// the outgoing message and then the reassembled reply: consecutive frames
+// are written straight into it and handed to the handler in place.
+//
+// Everything is driven by service() and incoming frames; nothing blocks.
+// Sending honours the receiver's flow control (block size, STmin), and
+// receiving answers first frames with the session's own flow control.
+#pragma once
+
+#include <Arduino.h>
+#include "CANManager.h"
+
+class IsoTp
+{
+public:
+    static constexpr uint8_t kMaxSessions = CANManager::kExtraFilters; // one RX filter each
+    static constexpr uint16_t kBufferSize = 1024;  // per session (ISO-TP allows 4095)
+    static constexpr uint16_t kTimeoutMs = 1000;   // N_Bs / N_Cr
+    static constexpr uint8_t kTxBurst = 4;         // CFs per service() when STmin is 0
+    static constexpr uint8_t kPadding = 0xCC;
+
+    enum class Result : uint8_t
+    {
+        Ok,
+        Timeout,       // flow control or consecutive frame did not arrive
+        Overflow,      // message larger than the buffer, or receiver refused it
+        SequenceError, // consecutive frame out of order (e.g. controller overrun)
+        TxFailed       // controller refused a frame
+    };
+
+    // Called with a complete message (data points into the session buffer and
+    // is valid until the next send()) or with an error for the session.
+    using Handler = void (*)(uint8_t session, Result result, const uint8_t *data, uint16_t len, void *ctx);
+
+    explicit IsoTp(CANManager &can) : _can(can) {}
+
+    // Route non-decoded frames from the CAN manager here.
+    void begin();
+
+    // Returns the session index, or -1 when no session/filter is free.
+    int8_t open(uint16_t txId, uint16_t rxId, Handler handler, void *ctx);
+    void close(uint8_t session);
+
+    // Flow control sent when this session receives a segmented message.
+    void setRxFlowControl(uint8_t session, uint8_t blockSize, uint8_t stMin);
+
+    // Queue a message; false if the session is busy or the message too long.
+    bool send(uint8_t session, const uint8_t *data, uint16_t len);
+    // Same, for a message the caller built directly in buffer(session).
+    bool sendBuffer(uint8_t session, uint16_t len);
+    uint8_t *buffer(uint8_t session) { return session < kMaxSessions ? _buffers[session] : nullptr; }
+    bool busy(uint8_t session) const;
+
+    void service();
+
+    static const __FlashStringHelper *resultName(Result r);
+
+private:
+    enum class State : uint8_t
+    {
+        Closed,
+        Idle,
+        TxWaitFc,
+        TxSending,
+        Rx
+    };
+
+    struct Session
+    {
+        State state = State::Closed;
+        uint16_t txId = 0;
+        uint16_t rxId = 0;
+        Handler handler = nullptr;
+        void *ctx = nullptr;
+        uint8_t rxBlockSize = 0;
+        uint8_t rxStMin = 0;
+
+        uint16_t len = 0;    // message length
+        uint16_t offset = 0; // bytes sent or received so far
+        uint8_t seq = 0;     // next consecutive frame sequence number
+        uint8_t blockLeft = 0;
+        uint8_t blockSize = 0; // receiver's BS while sending
+        uint32_t stMinUs = 0;  // receiver's STmin while sending
+        uint32_t lastUs = 0;   // last CF sent
+        uint32_t deadlineMs = 0;
+    };
+
+    static bool _onFrame(const CANManager::Frame &f, void *ctx);
+    bool _handle(uint8_t index, const CANManager::Frame &f);
+    void _onFlowControl(uint8_t index, const CANManager::Frame &f);
+    bool _sendConsecutive(uint8_t index);
+    bool _sendFlowControl(Session &s, uint8_t status);
+    bool _sendRaw(uint16_t id, const uint8_t *pci, uint8_t pciLen, const uint8_t *data, uint8_t len);
+    void _finish(uint8_t index, Result result);
+    static uint32_t _stMinToUs(uint8_t stMin);
+
+    CANManager &_can;
+    Session _sessions[kMaxSessions];
+    uint8_t _buffers[kMaxSessions][kBufferSize];
+};
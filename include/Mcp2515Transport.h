@@ -0,0 +1,251 @@
+// CanTransport over the Adafruit_MCP2515 driver (SPI).
+#pragma once
+#include <Adafruit_MCP2515.h>
+#include <SPI.h>
+#include "CanTransport.h"
+
+class Mcp2515Transport : public CanTransport
+{
+public:
+    explicit Mcp2515Transport(uint8_t csPin = PIN_CAN_CS) : _mcp(csPin), _csPin(csPin) {}
+
+    bool begin(uint32_t bitrate) override
+    {
+        _begun = false;
+        _probing = false;
+        if (!_mcp.begin(bitrate))
+            return false;
+        // Both masks match all 11 bits, so every filter is an exact ID. The
+        // controller reset clears the filters, so they are reapplied here.
+        if (!_mcp.setFilterMask(0, false, 0x7FF) || !_mcp.setFilterMask(1, false, 0x7FF))
+            return false;
+        for (uint8_t i = 0; i < kFilterSlots; ++i)
+        {
+            if (!_mcp.setFilter(i, false, (_used & (1u << i)) ? _ids[i] : kUnusedId))
+                return false;
+        }
+        _begun = true;
+        return true;
+    }
+
+    // The driver's begin() always ends in normal mode, so probing programs
+    // the controller directly: reset (configuration mode, all masks and
+    // filters 0, i.e. accept everything), bit timing, then listen-only.
+    // Frames are read with READ RX BUFFER until the next begin(), which also
+    // keeps probing independent of the driver having been started.
+    bool probe(uint32_t bitrate) override
+    {
+        const uint8_t *cnf = _timing(bitrate);
+        if (!cnf)
+            return false;
+        _begun = false;
+        SPI.begin();
+        pinMode(_csPin, OUTPUT);
+        digitalWrite(_csPin, HIGH);
+        _instruction(kInstrReset);
+        delayMicroseconds(10); // oscillator start-up after reset
+        _writeRegister(kRegCnf1, cnf[0]);
+        _writeRegister(kRegCnf2, cnf[1]);
+        _writeRegister(kRegCnf3, cnf[2]);
+        _writeRegister(kRegCanctrl, kOpListenOnly);
+        _probing = (_readRegister(kRegCanstat) & kOpMask) == kOpListenOnly;
+        return _probing;
+    }
+
+    // MERRF is set by any receive error, listen-only included; EFLG holds
+    // the error-counter state. Receive overflows are cleared but do not
+    // count, since a busy bus at the right rate can overflow as well.
+    bool takeErrors() override
+    {
+        uint8_t intf = _readRegister(kRegCanintf);
+        uint8_t eflg = _readRegister(kRegEflg);
+        _bitModify(kRegCanintf, kIntfMerrf | kIntfErrif, 0);
+        _bitModify(kRegEflg, kEflgOverflow, 0);
+        return (intf & kIntfMerrf) || (eflg & ~kEflgOverflow);
+    }
+    bool loopback() override { return _mcp.loopback(); }
+
+    // Before begin() the ID is only stored.
+    bool setFilter(uint8_t slot, uint16_t id) override
+    {
+        if (slot >= kFilterSlots || (_begun && !_mcp.setFilter(slot, false, id)))
+            return false;
+        _ids[slot] = id;
+        _used |= 1u << slot;
+        return true;
+    }
+
+    // A filter cannot be switched off, so an unused one matches kUnusedId.
+    bool clearFilter(uint8_t slot) override
+    {
+        if (slot >= kFilterSlots || (_begun && !_mcp.setFilter(slot, false, kUnusedId)))
+            return false;
+        _used &= ~(1u << slot);
+        return true;
+    }
+
+    bool receive(CanFrame &f) override
+    {
+        if (_probing)
+            return _probeReceive(f);
+        int packetSize = _mcp.parsePacket();
+        // parsePacket() returns the DLC, so a zero-length frame is only
+        // visible through packetId() (-1 when nothing was received).
+        long id = _mcp.packetId();
+        if (!packetSize && id < 0)
+            return false;
+
+        f = CanFrame{};
+        f.id = (uint32_t)id;
+        f.extended = _mcp.packetExtended();
+        f.rtr = _mcp.packetRtr();
+        f.dlc = (uint8_t)packetSize;
+        if (!f.rtr)
+        {
+            while (_mcp.available() && f.len < 8)
+            {
+                f.data[f.len++] = _mcp.read();
+            }
+        }
+        return true;
+    }
+
+    bool send(uint16_t id, const uint8_t *data, uint8_t len) override
+    {
+        if (!_mcp.beginPacket(id))
+            return false;
+        _mcp.write(data, len);
+        return _mcp.endPacket();
+    }
+
+    Adafruit_MCP2515 &mcp() { return _mcp; }
+
+private:
+    // The driver keeps its register access private, so probing and the
+    // error registers use the controller's own SPI instructions.
+    static constexpr uint8_t kInstrReset = 0xC0;
+    static constexpr uint8_t kInstrWrite = 0x02;
+    static constexpr uint8_t kInstrRead = 0x03;
+    static constexpr uint8_t kInstrBitModify = 0x05;
+    static constexpr uint8_t kInstrReadRxb0 = 0x90; // READ RX BUFFER from RXB0SIDH
+    static constexpr uint8_t kInstrReadRxb1 = 0x94; // ... from RXB1SIDH
+    static constexpr uint8_t kRegCanstat = 0x0E;
+    static constexpr uint8_t kRegCanctrl = 0x0F;
+    static constexpr uint8_t kRegCnf3 = 0x28;
+    static constexpr uint8_t kRegCnf2 = 0x29;
+    static constexpr uint8_t kRegCnf1 = 0x2A;
+    static constexpr uint8_t kRegCanintf = 0x2C;
+    static constexpr uint8_t kRegEflg = 0x2D;
+    static constexpr uint8_t kOpMask = 0xE0;       // REQOP/OPMOD
+    static constexpr uint8_t kOpListenOnly = 0x60;
+    static constexpr uint8_t kIntfRx0if = 0x01;
+    static constexpr uint8_t kIntfRx1if = 0x02;
+    static constexpr uint8_t kIntfErrif = 0x20;
+    static constexpr uint8_t kIntfMerrf = 0x80;
+    static constexpr uint8_t kEflgOverflow = 0xC0; // RX1OVR, RX0OVR
+
+    // CNF1-CNF3 for the Feather's 16 MHz crystal, as the driver programs them.
+    static const uint8_t *_timing(uint32_t bitrate)
+    {
+        static const struct
+        {
+            uint32_t bitrate;
+            uint8_t cnf[3];
+        } kTimings[] = {
+            {1000000, {0x00, 0xD0, 0x82}}, {500000, {0x00, 0xF0, 0x86}}, {250000, {0x41, 0xF1, 0x85}},
+            {200000, {0x01, 0xFA, 0x87}},  {125000, {0x03, 0xF0, 0x86}}, {100000, {0x03, 0xFA, 0x87}},
+            {80000, {0x03, 0xFF, 0x87}},   {50000, {0x07, 0xFA, 0x87}},  {40000, {0x07, 0xFF, 0x87}},
+            {20000, {0x0F, 0xFF, 0x87}},   {10000, {0x1F, 0xFF, 0x87}},  {5000, {0x3F, 0xFF, 0x87}},
+        };
+        for (const auto &t : kTimings)
+        {
+            if (t.bitrate == bitrate)
+                return t.cnf;
+        }
+        return nullptr;
+    }
+
+    // One frame from whichever receive buffer is full; reading the buffer
+    // with READ RX BUFFER clears its RXnIF.
+    bool _probeReceive(CanFrame &f)
+    {
+        uint8_t intf = _readRegister(kRegCanintf);
+        if (!(intf & (kIntfRx0if | kIntfRx1if)))
+            return false;
+        uint8_t raw[13]; // SIDH SIDL EID8 EID0 DLC D0-D7
+        _select();
+        SPI.transfer((intf & kIntfRx0if) ? kInstrReadRxb0 : kInstrReadRxb1);
+        for (uint8_t &b : raw)
+            b = SPI.transfer(0x00);
+        _deselect();
+
+        f = CanFrame{};
+        f.extended = raw[1] & 0x08; // IDE
+        f.id = ((uint32_t)raw[0] << 3) | (raw[1] >> 5);
+        if (f.extended)
+            f.id = (f.id << 18) | ((uint32_t)(raw[1] & 0x03) << 16) | ((uint32_t)raw[2] << 8) | raw[3];
+        f.rtr = f.extended ? (raw[4] & 0x40) : (raw[1] & 0x10); // RTR, or SRR for standard frames
+        f.dlc = raw[4] & 0x0F;
+        f.len = f.rtr ? 0 : (f.dlc > 8 ? 8 : f.dlc);
+        memcpy(f.data, raw + 5, f.len);
+        return true;
+    }
+
+    void _select()
+    {
+        SPI.beginTransaction(SPISettings(10000000, MSBFIRST, SPI_MODE0));
+        digitalWrite(_csPin, LOW);
+    }
+
+    void _deselect()
+    {
+        digitalWrite(_csPin, HIGH);
+        SPI.endTransaction();
+    }
+
+    void _instruction(uint8_t instruction)
+    {
+        _select();
+        SPI.transfer(instruction);
+        _deselect();
+    }
+
+    uint8_t _readRegister(uint8_t address)
+    {
+        _select();
+        SPI.transfer(kInstrRead);
+        SPI.transfer(address);
+        uint8_t value = SPI.transfer(0x00);
+        _deselect();
+        return value;
+    }
+
+    void _writeRegister(uint8_t address, uint8_t value)
+    {
+        _select();
+        SPI.transfer(kInstrWrite);
+        SPI.transfer(address);
+        SPI.transfer(value);
+        _deselect();
+    }
+
+    void _bitModify(uint8_t address, uint8_t mask, uint8_t value)
+    {
+        _select();
+        SPI.transfer(kInstrBitModify);
+        SPI.transfer(address);
+        SPI.transfer(mask);
+        SPI.transfer(value);
+        _deselect();
+    }
+
+    Adafruit_MCP2515 _mcp;
+    uint8_t _csPin;
+    // CAN 2.0A forbids IDs 0x7F0-0x7FF, so nothing on the bus sends this.
+    static constexpr uint16_t kUnusedId = 0x7FF;
+
+    uint16_t _ids[kFilterSlots] = {0};
+    uint8_t _used = 0; // bit i: slot i holds a filter
+    bool _begun = false;
+    bool _probing = false; // probe() owns the controller until begin()
+};
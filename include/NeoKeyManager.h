@@ -1,4 +1,6 @@
-// Encapsulates interaction with Adafruit NeoKey 1x4 module.
+// Encapsulates interaction with one or more chained Adafruit NeoKey 1x4
+// modules. Keys are numbered globally in board order (board 0 owns keys 0-3,
+// board 1 keys 4-7, ...) and reported as bit masks.
 #pragma once
 
 #include <Arduino.h>
@@ -7,25 +9,53 @@
 class NeoKeyManager
 {
 public:
-    bool begin(uint8_t address);
+    static constexpr uint8_t kKeysPerBoard = 4;
+    static constexpr uint8_t kMaxBoards = 8; // 32 keys, one bit each
+
+    bool begin(const uint8_t *addresses, uint8_t count);
+    bool begin(uint8_t address) { return begin(&address, 1); }
     void update();
     void setPressedColor(uint32_t color) { _pressedColor = color; }
-    void setDebounceTime(uint16_t ms) { _debounceMs = ms; }
+    // A key changes state once its raw reading has disagreed with the
+    // debounced state for debounceMs of consecutive scans (max 15 scans).
+    void setDebounceTime(uint16_t debounceMs, uint16_t scanIntervalMs);
     void setKeyColor(uint8_t keyIndex, uint8_t r, uint8_t g, uint8_t b);
-    uint8_t buttons() const { return _currentButtons; }
-    uint8_t buttonsChanged() const { return _changedMask; }
-    uint8_t justPressed();
-    uint8_t justReleased();
+    uint8_t keyCount() const { return (uint8_t)(_boardCount * kKeysPerBoard); }
+    uint32_t buttons() const { return _currentButtons; }
+    uint32_t buttonsChanged() const { return _changedMask; }
+    uint32_t justPressed();
+    uint32_t justReleased();
 
 private:
-    Adafruit_NeoKey_1x4 _neokey;
-    uint8_t _prevButtons = 0;
-    uint8_t _currentButtons = 0;
-    uint8_t _changedMask = 0;
-    uint8_t _justPressedMask = 0;
-    uint8_t _justReleasedMask = 0;
+    // Split-phase GPIO read: request() points the seesaw at its GPIO bulk
+    // register and collect() fetches the result on the next scan, so the
+    // board's conversion time elapses between scans instead of in a delay.
+    // Pixel writes share the register pointer, so a board whose pixels were
+    // written after request() must not be collected until requested again.
+    // The public read() always rewrites the pointer, so collect() reads
+    // through the library's protected _i2c_dev; the library version is
+    // pinned in platformio.ini for that reason.
+    class Board : public Adafruit_NeoKey_1x4
+    {
+    public:
+        bool request() { return write(SEESAW_GPIO_BASE, SEESAW_GPIO_BULK); }
+        bool collect(uint8_t &keys);
+    };
+
+    void _debounce(uint32_t raw);
+
+    Board _boards[kMaxBoards];
+    uint8_t _boardCount = 0;
+    uint8_t _requested = 0; // bit per board whose pointer still selects GPIO
+
+    uint32_t _raw = 0;
+    uint32_t _currentButtons = 0;
+    uint32_t _changedMask = 0;
+    uint32_t _justPressedMask = 0;
+    uint32_t _justReleasedMask = 0;
     uint32_t _pressedColor = 0; // GRB packed color
 
-    uint16_t _debounceMs = 0; // 0 = disabled
-    uint32_t _lastChangeTime[4] = {0, 0, 0, 0};
+    // Vertical counters: bit i of plane k is bit k of key i's countdown.
+    uint32_t _count[4] = {0, 0, 0, 0};
+    uint8_t _debouncePreload = 0; // scans a change must hold after the first
 };
@@ -0,0 +1,152 @@
+// Rules binding decoded CAN signals to LEDs, transmit frames and the status
+// LED. Each rule is compiled once into a few bytes of stack bytecode:
+//
+//   when <expr> then <action> [else <action>]
+//
+//   expr   := term | expr and expr | expr or expr | not expr | ( expr )
+//   term   := <signal> [== != < <= > >= <int>]    (bare signal = non-zero)
+//   action := led <key> <r> <g> <b>
+//           | blink <key> <r> <g> <b> <period_ms>
+//           | tx <id> [b0 b1 ...]                    (hex)
+//           | status off|waiting|ok|error
+//
+// Signal names are those in Signals.h. A rule's action runs when its
+// predicate changes value (the else action when it becomes false). Rules are
+// indexed by the signals they reference, so setSignal() only re-evaluates
+// the rules that can be affected and nothing is scanned per loop. LEDs set by
+// a rule that depends on a stale (restored) value are dimmed until every
+// such value has been confirmed live.
+#pragma once
+
+#include <Arduino.h>
+#include "Signals.h"
+#include "NeoKeyManager.h"
+#include "CANManager.h"
+#include "StatusLED.h"
+
+class RuleEngine
+{
+public:
+    static constexpr uint8_t kMaxRules = 32;
+    static constexpr uint16_t kCodeSize = 512;
+    static constexpr uint8_t kMaxBlinks = 8;
+    static constexpr uint8_t kStackDepth = 8;
+    static constexpr uint8_t kMaxLine = 96;
+    static constexpr uint8_t kMaxTokens = 40;
+    static constexpr uint8_t kStaleDimShift = 2; // stale-driven LEDs at 1/4
+
+    RuleEngine(NeoKeyManager &keys, CANManager &can, StatusLED &status)
+        : _keys(keys), _can(can), _status(status) {}
+
+    // Replace the rule set. Lines starting with '#' and blank lines are
+    // ignored; lines that fail to compile are reported and skipped.
+    // Returns the number of rules compiled.
+    uint8_t load(const char *text);
+    // Same, reading from LittleFS. Returns false (and keeps the current
+    // rules) if the file cannot be opened.
+    bool loadFile(const char *path);
+    void clear();
+
+    // Feed a decoded signal value; re-evaluates dependent rules on change.
+    // A stale value (warm start) is used like a live one but dims the LEDs
+    // it drives; the first live value brings them to full brightness.
+    void setSignal(SignalId id, int32_t value, bool stale = false);
+    // Forget a signal's value: its rules wait for a new one and the LEDs
+    // they lit go dark.
+    void dropSignal(SignalId id);
+
+    // Advance blink actions; only touches keys that are currently blinking.
+    void update(uint32_t nowMs);
+
+    uint8_t ruleCount() const { return _ruleCount; }
+    uint16_t codeBytes() const { return _codeLen; }
+    void printRules(Print &out) const;
+
+private:
+    enum Op : uint8_t
+    {
+        OP_SIG = 1, // + signal index
+        OP_CONST,   // + int16 (little-endian)
+        OP_EQ,
+        OP_NE,
+        OP_LT,
+        OP_LE,
+        OP_GT,
+        OP_GE,
+        OP_AND,
+        OP_OR,
+        OP_NOT
+    };
+
+    enum class ActionType : uint8_t
+    {
+        None,
+        Led,
+        Blink,
+        Tx,
+        Status
+    };
+
+    struct Action
+    {
+        ActionType type = ActionType::None;
+        uint8_t key = 0;
+        uint8_t r = 0, g = 0, b = 0;
+        uint8_t len = 0;       // Tx: DLC
+        uint16_t id = 0;       // Tx: CAN ID, Blink: period ms
+        uint8_t data[8] = {0}; // Tx: payload, Status: data[0] = state
+    };
+
+    struct Rule
+    {
+        uint16_t codeStart;
+        uint8_t codeLen;
+        uint32_t deps; // bit per SignalId
+        int8_t last;   // -1 until first evaluation
+        Action then;
+        Action otherwise;
+    };
+
+    struct Blink
+    {
+        bool active;
+        uint8_t key;
+        uint8_t r, g, b;
+        uint16_t periodMs;
+        uint32_t lastToggleMs;
+        bool lit;
+    };
+
+    // Compiler
+    void _addLine(char *line, uint16_t lineNo);
+    bool _compileLine(char *line, const char **error);
+    bool _compileExpr(char **tok, uint8_t count, uint8_t &pos, uint8_t &depth, uint32_t &deps, const char **error);
+    bool _compileAnd(char **tok, uint8_t count, uint8_t &pos, uint8_t &depth, uint32_t &deps, const char **error);
+    bool _compileUnary(char **tok, uint8_t count, uint8_t &pos, uint8_t &depth, uint32_t &deps, const char **error);
+    bool _compileAction(char **tok, uint8_t count, uint8_t &pos, Action &a, const char **error);
+    bool _emit(uint8_t byte, const char **error);
+
+    // Runtime
+    void _evaluateAll();
+    void _evaluate(uint8_t ruleIndex, bool refresh = false);
+    int32_t _run(const Rule &r) const;
+    void _execute(const Action &a, bool dim);
+    void _startBlink(const Action &a, bool dim);
+    void _cancelBlink(uint8_t key);
+
+    NeoKeyManager &_keys;
+    CANManager &_can;
+    StatusLED &_status;
+
+    uint8_t _code[kCodeSize];
+    uint16_t _codeLen = 0;
+    Rule _rules[kMaxRules];
+    uint8_t _ruleCount = 0;
+    uint32_t _rulesBySignal[SIGNAL_COUNT] = {0}; // bit per rule index
+
+    int32_t _values[SIGNAL_COUNT] = {0};
+    uint32_t _known = 0; // bit per SignalId that has received a value
+    uint32_t _stale = 0; // bit per SignalId whose value is a restored one
+
+    Blink _blinks[kMaxBlinks] = {};
+};
@@ -0,0 +1,38 @@
+// Line-based command console on Serial. Input is gathered without blocking;
+// each complete line is split on spaces and dispatched to a registered handler.
+#pragma once
+
+#include <Arduino.h>
+
+class SerialConsole
+{
+public:
+    using Handler = void (*)(uint8_t argc, char **argv);
+
+    static constexpr uint8_t kMaxCommands = 16;
+    static constexpr uint8_t kMaxArgs = 12;
+    static constexpr uint8_t kLineLen = 96;
+
+    // name and help must outlive the console (string literals).
+    bool addCommand(const char *name, Handler handler, const char *help);
+
+    // Drain pending serial input; call every loop iteration.
+    void update();
+
+private:
+    struct Command
+    {
+        const char *name;
+        const char *help;
+        Handler handler;
+    };
+
+    void _dispatch();
+    void _printHelp();
+
+    Command _commands[kMaxCommands];
+    uint8_t _commandCount = 0;
+    char _line[kLineLen + 1];
+    uint8_t _len = 0;
+    bool _overflow = false;
+};
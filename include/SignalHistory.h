@@ -0,0 +1,62 @@
+// Fixed-memory time-series history for decoded signals. Each signal keeps a
+// ring of (timestamp, value) change events plus a ring of time buckets with
+// pre-aggregated min/max/sample/change counts. Recording and querying a
+// bucket are O(1) and nothing is ever allocated.
+#pragma once
+
+#include <Arduino.h>
+#include "Signals.h"
+
+class SignalHistory
+{
+public:
+    static constexpr uint8_t kEventsPerSignal = 32;
+    static constexpr uint8_t kBuckets = 20;
+    static constexpr uint16_t kBucketMs = 500; // kBuckets * kBucketMs = 10 s window
+
+    struct Event
+    {
+        uint32_t ms;
+        int32_t value;
+    };
+
+    struct Bucket
+    {
+        uint32_t index = 0; // startMs / kBucketMs; identifies which window the slot holds
+        int32_t min = 0;
+        int32_t max = 0;
+        uint16_t samples = 0;
+        uint16_t changes = 0;
+    };
+
+    // Record one received sample. Only value changes enter the event ring;
+    // every sample is counted in its bucket.
+    void record(SignalId id, uint32_t ms, int32_t value);
+
+    bool hasValue(SignalId id) const { return _sig[(uint8_t)id].hasValue; }
+    int32_t lastValue(SignalId id) const { return _sig[(uint8_t)id].last; }
+
+    // Change events, newest first (ago = 0 is the most recent).
+    uint8_t eventCount(SignalId id) const { return _sig[(uint8_t)id].count; }
+    bool event(SignalId id, uint8_t ago, Event &out) const;
+
+    // Aggregate for the bucket 'ago' windows before the one containing nowMs.
+    // Returns false if nothing was recorded in that window.
+    bool bucket(SignalId id, uint8_t ago, uint32_t nowMs, Bucket &out) const;
+
+    void printSummary(Print &out, uint32_t nowMs) const;
+    void printSignal(Print &out, SignalId id, uint32_t nowMs) const;
+
+private:
+    struct SignalState
+    {
+        Event events[kEventsPerSignal];
+        Bucket buckets[kBuckets];
+        uint8_t head = 0; // next event slot
+        uint8_t count = 0;
+        bool hasValue = false;
+        int32_t last = 0;
+    };
+
+    SignalState _sig[SIGNAL_COUNT];
+};
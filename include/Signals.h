@@ -0,0 +1,37 @@
+// Identifiers for the decoded CAN signals the deck tracks, shared by the
+// history store and anything else that wants to refer to a signal by index.
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+enum class SignalId : uint8_t
+{
+    IndicatorLeft,  // VCFRONT_indicatorLeftRequest (0x3F5)
+    IndicatorRight, // VCFRONT_indicatorRightRequest (0x3F5)
+    RearIntSwitch,  // VCRIGHT_rearIntSwitchPressed (0x103)
+    HighBeamStalk,  // SCCM_highBeamStalkStatus (0x249)
+    TurnStalk,      // SCCM_turnIndicatorStalkStatus (0x249)
+    WashWipe,       // SCCM_washWipeButtonStatus (0x249)
+    Count
+};
+
+constexpr uint8_t SIGNAL_COUNT = (uint8_t)SignalId::Count;
+
+inline const char *signalName(SignalId id)
+{
+    static const char *const names[SIGNAL_COUNT] = {
+        "indicatorLeft", "indicatorRight", "rearIntSwitch", "highBeamStalk", "turnStalk", "washWipe"};
+    return (uint8_t)id < SIGNAL_COUNT ? names[(uint8_t)id] : "?";
+}
+
+// Returns SignalId::Count if the name is unknown.
+inline SignalId signalFromName(const char *name)
+{
+    for (uint8_t i = 0; i < SIGNAL_COUNT; ++i)
+    {
+        if (strcmp(name, signalName((SignalId)i)) == 0)
+            return (SignalId)i;
+    }
+    return SignalId::Count;
+}
@@ -0,0 +1,81 @@
+// CanTransport over a Linux SocketCAN interface (can0, vcan0, ...), so the
+// deck logic can run on a Linux host or in CI. Frames are fetched in batches
+// with recvmmsg(), each with its kernel receive timestamp, and the
+// acceptance filters become a CAN_RAW_FILTER list so the kernel drops
+// everything else before it reaches user space.
+//
+// The bitrate belongs to the interface (ip link set can0 type can bitrate
+// ...), so begin() ignores it, and there is no listen-only mode. In loopback
+// our own frames are received back but, unlike on the MCP2515, still reach
+// the interface.
+#pragma once
+
+#ifdef __linux__
+
+#include "CanTransport.h"
+#include <linux/can.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <time.h>
+
+class SocketCanTransport : public CanTransport
+{
+public:
+    static constexpr uint8_t kBatch = 32;             // frames per recvmmsg()
+    static constexpr int kRcvBufBytes = 1024 * 1024; // absorbs bursts between polls
+
+    struct Stats
+    {
+        uint64_t frames = 0;
+        uint64_t batches = 0;         // recvmmsg() calls that returned frames
+        uint32_t kernelDrops = 0;     // socket queue overflows (SO_RXQ_OVFL)
+        uint64_t latencyTotalUs = 0;  // kernel timestamp to receive()
+        uint32_t latencyMaxUs = 0;
+        uint64_t sent = 0;
+        uint64_t sendFailed = 0;
+    };
+
+    explicit SocketCanTransport(const char *ifname);
+    ~SocketCanTransport() override;
+
+    bool begin(uint32_t bitrate) override;
+    bool probe(uint32_t bitrate) override
+    {
+        (void)bitrate;
+        return false; // no listen-only mode
+    }
+    bool loopback() override;
+    bool setFilter(uint8_t slot, uint16_t id) override;
+    bool clearFilter(uint8_t slot) override;
+    bool takeErrors() override { return false; } // error frames are not subscribed
+    bool receive(CanFrame &f) override;
+    bool send(uint16_t id, const uint8_t *data, uint8_t len) override;
+    void printStats(Print &out) const override;
+
+    const Stats &stats() const { return _stats; }
+
+private:
+    bool _open();
+    bool _applyFilters();
+    bool _setOwnMessages(bool enabled);
+    void _fill();
+    static uint64_t _realtimeUs();
+
+    char _ifname[IFNAMSIZ];
+    int _fd = -1;
+    uint16_t _ids[kFilterSlots] = {0};
+    uint8_t _used = 0; // bit i: slot i holds a filter
+
+    // recvmmsg() batch; frames _next.._count-1 have not been handed out yet.
+    struct can_frame _frames[kBatch];
+    struct iovec _iov[kBatch];
+    struct mmsghdr _msgs[kBatch];
+    uint8_t _control[kBatch][CMSG_SPACE(sizeof(struct timespec)) + CMSG_SPACE(sizeof(uint32_t))];
+    uint64_t _stampUs[kBatch];
+    uint8_t _count = 0;
+    uint8_t _next = 0;
+
+    Stats _stats;
+};
+
+#endif
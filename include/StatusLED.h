@@ -2,9 +2,17 @@
 #include <Arduino.h>
 #include <stdint.h>
 
+// Status NeoPixel plus optional extra WS2812 pixels chained on the same data
+// pin. On the RP2040 the pixels are clocked out by a PIO state machine fed by
+// DMA, so show() returns immediately and never masks interrupts (the CAN
+// controller's INT line keeps being serviced). Other targets use
+// Adafruit_NeoPixel.
 class StatusLED
 {
 public:
+    static constexpr uint8_t kMaxPixels = 16;
+    static constexpr uint16_t kUpdateGapMs = 50; // update() calls further apart don't count as polling
+
     enum class State : uint8_t
     {
         Off,
@@ -13,24 +21,42 @@ public:
         Error
     };
 
-    StatusLED(uint8_t powerPin = 20, uint8_t dataPin = 21, uint8_t brightness = 32);
+    StatusLED(uint8_t powerPin = 20, uint8_t dataPin = 21, uint8_t brightness = 32, uint8_t numPixels = 1);
 
     bool begin();
     void setState(State s);
     State state() const { return _state; }
 
     // Non-blocking update; call regularly if wanting animation on "Waiting" state.
+    // Also sends a frame that was deferred while the previous one was in flight.
+    // When it is not being called, setters wait for the wire instead (< 1 ms).
     void update();
 
     // Direct color override (R,G,B 0-255). Also sets state to Off if all zero.
     void setColor(uint8_t r, uint8_t g, uint8_t b);
 
+    // Pixel 0 shows the state; the rest are free for the caller. setPixel()
+    // only stages a colour, show() sends all of them.
+    uint8_t numPixels() const { return _numPixels; }
+    void setPixel(uint8_t index, uint8_t r, uint8_t g, uint8_t b);
+    void show();
+
+    // Fill pixels 1..n-1 as a bar proportional to value/max (the last lit
+    // pixel is dimmed for the remainder) and show it. Pixel 0 is never part
+    // of the bar, so with a single pixel this does nothing.
+    void showBar(uint16_t value, uint16_t max, uint8_t r, uint8_t g, uint8_t b);
+
 private:
     void _showColor(uint8_t r, uint8_t g, uint8_t b);
 
     uint8_t _powerPin;
     uint8_t _dataPin;
     uint8_t _brightness;
+    uint8_t _numPixels;
+    uint32_t _pixels[kMaxPixels] = {}; // 0x00RRGGBB, before brightness
+    bool _pending{false};              // show() deferred while a frame was in flight
+    bool _polled{false};               // update() has been called
+    uint32_t _lastUpdateMs{0};
     State _state{State::Off};
     uint32_t _lastAnimMs{0};
     uint8_t _animPhase{0};
@@ -0,0 +1,76 @@
+// Minimal UDS (ISO 14229) client on top of IsoTp: ReadDataByIdentifier
+// (0x22) and WriteDataByIdentifier (0x2E). Each outstanding request holds
+// one ISO-TP session, so requests to different ECUs run concurrently.
+// "Response pending" (NRC 0x78) extends the wait from P2 to P2*.
+#pragma once
+
+#include <Arduino.h>
+#include "IsoTp.h"
+
+class UdsClient
+{
+public:
+    static constexpr uint16_t kP2Ms = 1000;     // first response
+    static constexpr uint16_t kP2StarMs = 5000; // after "response pending"
+
+    enum class Status : uint8_t
+    {
+        Positive,
+        Negative,  // nrc holds the negative response code
+        Timeout,   // no (final) response within P2/P2*
+        Transport, // ISO-TP error, see transport
+        Invalid    // response does not match the request
+    };
+
+    struct Response
+    {
+        Status status = Status::Positive;
+        IsoTp::Result transport = IsoTp::Result::Ok;
+        uint8_t nrc = 0;
+        uint16_t did = 0;
+        const uint8_t *data = nullptr; // DID payload, points into the ISO-TP buffer
+        uint16_t len = 0;
+        uint32_t elapsedUs = 0; // request sent to final response
+    };
+
+    using Callback = void (*)(const Response &r, void *ctx);
+
+    explicit UdsClient(IsoTp &tp) : _tp(tp) {}
+
+    // Start a request; false when no session is free or the send failed.
+    bool readDid(uint16_t txId, uint16_t rxId, uint16_t did, Callback cb, void *ctx);
+    bool writeDid(uint16_t txId, uint16_t rxId, uint16_t did, const uint8_t *data, uint16_t len, Callback cb, void *ctx);
+
+    // Flow control used for replies on new sessions (block size, STmin).
+    void setFlowControl(uint8_t blockSize, uint8_t stMin)
+    {
+        _blockSize = blockSize;
+        _stMin = stMin;
+    }
+
+    // P2 timeouts; call every loop iteration.
+    void service();
+
+    static const __FlashStringHelper *statusName(Status s);
+
+private:
+    struct Pending
+    {
+        bool active = false;
+        uint8_t sid = 0;
+        uint16_t did = 0;
+        Callback cb = nullptr;
+        void *ctx = nullptr;
+        uint32_t startUs = 0;
+        uint32_t deadlineMs = 0;
+    };
+
+    bool _start(uint16_t txId, uint16_t rxId, uint8_t sid, uint16_t did, const uint8_t *data, uint16_t len, Callback cb, void *ctx);
+    static void _onMessage(uint8_t session, IsoTp::Result result, const uint8_t *data, uint16_t len, void *ctx);
+    void _complete(uint8_t session, Response &r);
+
+    IsoTp &_tp;
+    Pending _pending[IsoTp::kMaxSessions];
+    uint8_t _blockSize = 0;
+    uint8_t _stMin = 0;
+};
@@ -0,0 +1,96 @@
+// Warm-start snapshot of decoded vehicle state and deck settings on LittleFS,
+// so bound LEDs come back at boot before the first live frame arrives.
+//
+// Two files are written alternately (A/B); each carries a magic, format
+// version, payload size, sequence number and CRC-32, and restore() takes the
+// newest one that validates, so a torn or corrupt write falls back to the
+// previous snapshot. Writes are wear-aware: nothing is written unless the
+// state differs from the last snapshot, has held for WARM_START_SETTLE_MS
+// and WARM_START_MIN_INTERVAL_MS has passed since the previous write.
+//
+// Restored signal values are stale until a live sample for the signal
+// arrives through setSignal(). Those still stale WARM_START_STALE_MS after
+// restore() expire, so a quiet bus does not show old state indefinitely.
+#pragma once
+
+#include <Arduino.h>
+#include "HardwareConfig.h"
+#include "Signals.h"
+
+class WarmStart
+{
+public:
+    static constexpr uint32_t kMagic = 0x5357434F; // "OCWS"
+    static constexpr uint16_t kVersion = 1;
+    static constexpr uint8_t kMaxFilterIds = 8;
+
+    // Everything that survives a reset. Plain data, written as-is.
+    struct Snapshot
+    {
+        uint32_t bitrate = 0;
+        uint32_t signalMask = 0; // bit per SignalId with a stored value
+        int32_t values[SIGNAL_COUNT] = {};
+        uint8_t rulesDefault = 0; // built-in rules forced with "rules default"
+        uint8_t filterMode = 0;   // CanReplay::FilterMode
+        uint8_t filterCount = 0;
+        uint8_t reserved = 0;
+        uint16_t filterIds[kMaxFilterIds] = {};
+    };
+
+    // Load the newest valid snapshot into snapshot(). Only signals in
+    // signalMask are kept, and those are marked stale. False if neither
+    // file validates (the snapshot is then empty).
+    bool restore(uint32_t signalMask);
+
+    const Snapshot &snapshot() const { return _current; }
+    bool restored() const { return _restoredSlot >= 0; }
+    uint32_t loadUs() const { return _loadUs; }
+
+    // Live state; a signal outside the restore mask is never stored.
+    void setSignal(SignalId id, int32_t value);
+    void setBitrate(uint32_t bitrate);
+    void setRulesDefault(bool useDefault);
+    void setReplayFilter(uint8_t mode, const uint16_t *ids, uint8_t count);
+
+    uint32_t staleMask() const { return _staleMask; }
+    // Signals that just expired (bit per SignalId), each reported once; they
+    // are no longer stale, and their restored values should be dropped.
+    uint32_t expire(uint32_t nowMs);
+
+    // Writes the snapshot when due; call every loop iteration.
+    void service(uint32_t nowMs);
+    // Write immediately, ignoring the rate limit.
+    bool save();
+
+    void printStatus(Print &out) const;
+
+private:
+    struct Header
+    {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t size; // sizeof(Snapshot)
+        uint32_t seq;
+        uint32_t crc; // over seq and the payload
+    };
+
+    static bool _read(uint8_t slot, Header &h, Snapshot &s);
+    static uint32_t _crc(uint32_t seq, const Snapshot &s);
+    void _changed();
+
+    Snapshot _current;
+    Snapshot _written; // last snapshot on flash (or restored)
+    uint32_t _restoreMask = 0;
+    uint32_t _staleMask = 0;
+    uint32_t _expiredMask = 0;
+    uint32_t _restoreMs = 0;
+    uint32_t _seq = 0;
+    int8_t _restoredSlot = -1;
+    uint8_t _nextSlot = 0;
+    uint32_t _loadUs = 0;
+    bool _dirty = false;
+    uint32_t _changedMs = 0;
+    uint32_t _lastWriteMs = 0;
+    uint32_t _writes = 0;
+    uint32_t _writeUs = 0; // duration of the last write
+};
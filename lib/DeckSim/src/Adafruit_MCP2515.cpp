@@ -0,0 +1,432 @@
+#include "Adafruit_MCP2515.h"
+
+namespace
+{
+    constexpr uint8_t kInstrReset = 0xC0;
+    constexpr uint8_t kInstrWrite = 0x02;
+    constexpr uint8_t kInstrRead = 0x03;
+    constexpr uint8_t kInstrBitModify = 0x05;
+    constexpr uint8_t kInstrReadRxMask = 0xF9; // READ RX BUFFER is 1001 0nm0
+    constexpr uint8_t kInstrReadRx = 0x90;
+    constexpr uint8_t kRegCanstat = 0x0E;
+    constexpr uint8_t kRegCanctrl = 0x0F;
+    constexpr uint8_t kRegRec = 0x1D;
+    constexpr uint8_t kRegCnf3 = 0x28;
+    constexpr uint8_t kRegCnf1 = 0x2A;
+    constexpr uint8_t kRegCanintf = 0x2C;
+    constexpr uint8_t kRegEflg = 0x2D;
+    constexpr uint8_t kIntfErrif = 0x20;
+    constexpr uint8_t kIntfMerrf = 0x80;
+    constexpr uint8_t kEflgEwarn = 0x01;
+    constexpr uint8_t kEflgRxwar = 0x02;
+    constexpr uint8_t kEflgRxep = 0x08;
+    constexpr uint8_t kEflgRx1ovr = 0x80;
+    constexpr uint8_t kEflgOverflow = 0xC0; // RX1OVR, RX0OVR: the only writable bits
+
+    // CNF1-CNF3 the driver programs for a 16 MHz crystal.
+    struct Timing
+    {
+        long baud;
+        uint8_t cnf[3];
+    };
+    constexpr Timing kTimings[] = {
+        {1000000, {0x00, 0xD0, 0x82}}, {500000, {0x00, 0xF0, 0x86}}, {250000, {0x41, 0xF1, 0x85}},
+        {200000, {0x01, 0xFA, 0x87}},  {125000, {0x03, 0xF0, 0x86}}, {100000, {0x03, 0xFA, 0x87}},
+        {80000, {0x03, 0xFF, 0x87}},   {50000, {0x07, 0xFA, 0x87}},  {40000, {0x07, 0xFF, 0x87}},
+        {20000, {0x0F, 0xFF, 0x87}},   {10000, {0x1F, 0xFF, 0x87}},  {5000, {0x3F, 0xFF, 0x87}},
+    };
+}
+
+Adafruit_MCP2515::Adafruit_MCP2515(int8_t csPin)
+{
+    (void)csPin;
+    Sim::detail::attachController(this);
+}
+
+Adafruit_MCP2515::~Adafruit_MCP2515()
+{
+    Sim::detail::detachController(this);
+}
+
+int Adafruit_MCP2515::begin(long baudRate)
+{
+    switch (baudRate)
+    {
+    case 1000000:
+    case 500000:
+    case 250000:
+    case 200000:
+    case 125000:
+    case 100000:
+    case 80000:
+    case 50000:
+    case 40000:
+    case 20000:
+    case 10000:
+    case 5000:
+        break;
+    default:
+        return 0;
+    }
+    _baud = baudRate;
+    _rxCount = 0;
+    _errorIntf = _eflg = _rec = 0;
+    _mode = Mode::Normal;
+    return 1;
+}
+
+void Adafruit_MCP2515::end()
+{
+    _mode = Mode::Sleep;
+}
+
+int Adafruit_MCP2515::beginPacket(int id, int dlc, bool rtr)
+{
+    if (id < 0 || id > 0x7FF)
+        return 0;
+    _tx = Sim::CanFrame{};
+    _tx.id = (uint32_t)id;
+    _tx.rtr = rtr;
+    _tx.len = dlc >= 0 ? (uint8_t)(dlc > 8 ? 8 : dlc) : 0;
+    _txActive = true;
+    return 1;
+}
+
+int Adafruit_MCP2515::beginExtendedPacket(long id, int dlc, bool rtr)
+{
+    if (id < 0 || id > 0x1FFFFFFF)
+        return 0;
+    _tx = Sim::CanFrame{};
+    _tx.id = (uint32_t)id;
+    _tx.extended = true;
+    _tx.rtr = rtr;
+    _tx.len = dlc >= 0 ? (uint8_t)(dlc > 8 ? 8 : dlc) : 0;
+    _txActive = true;
+    return 1;
+}
+
+size_t Adafruit_MCP2515::write(uint8_t byte)
+{
+    return write(&byte, 1);
+}
+
+size_t Adafruit_MCP2515::write(const uint8_t *buffer, size_t size)
+{
+    if (!_txActive)
+        return 0;
+    size_t n = 0;
+    while (n < size && _tx.len < 8)
+        _tx.data[_tx.len++] = buffer[n++];
+    return n;
+}
+
+int Adafruit_MCP2515::endPacket()
+{
+    if (!_txActive)
+        return 0;
+    _txActive = false;
+    // ID/DLC/data registers, TXREQ, completion poll and flag clear
+    _spi(5 + _tx.len + 3);
+    switch (_mode)
+    {
+    case Mode::Normal:
+        _wire(_tx.len);
+        Sim::detail::recordTx(_tx);
+        return 1;
+    case Mode::Loopback:
+        _wire(_tx.len);
+        _receive(_tx);
+        return 1;
+    default:
+        return 0;
+    }
+}
+
+int Adafruit_MCP2515::parsePacket()
+{
+    if (_rxCount == 0)
+    {
+        _spi(1); // CANINTF
+        _rxValid = false;
+        _rxIndex = _rxLength = 0;
+        return 0;
+    }
+    _rxValid = true;
+    _rx = _rxBuf[0];
+    // CANINTF, ID/DLC registers, data bytes, flag clear
+    _spi(1 + 5 + (_rx.rtr ? 0 : _rx.len) + 1);
+    _rxBuf[0] = _rxBuf[1];
+    _rxCount--;
+    _rxIndex = 0;
+    _rxLength = _rx.rtr ? 0 : _rx.len;
+    return _rx.len;
+}
+
+int Adafruit_MCP2515::observe()
+{
+    _rec = 0;
+    _eflg &= kEflgOverflow;
+    _mode = Mode::ListenOnly;
+    return 1;
+}
+
+int Adafruit_MCP2515::loopback()
+{
+    _mode = Mode::Loopback;
+    return 1;
+}
+
+int Adafruit_MCP2515::sleep()
+{
+    _mode = Mode::Sleep;
+    return 1;
+}
+
+int Adafruit_MCP2515::wakeup()
+{
+    _mode = Mode::Normal;
+    return 1;
+}
+
+bool Adafruit_MCP2515::setFilterMask(uint8_t mask, bool extended, uint32_t value)
+{
+    if (mask > 1 || extended)
+        return false;
+    _masks[mask] = value & 0x7FF;
+    return true;
+}
+
+bool Adafruit_MCP2515::setFilter(uint8_t filter, bool extended, uint32_t value)
+{
+    if (filter > 5 || extended)
+        return false;
+    _filters[filter] = value & 0x7FF;
+    return true;
+}
+
+void Adafruit_MCP2515::_spi(uint16_t registerAccesses)
+{
+    _pendingNs += registerAccesses * kRegisterAccessNs;
+    Sim::advanceUs(_pendingNs / 1000);
+    _pendingNs %= 1000;
+}
+
+void Adafruit_MCP2515::_wire(uint8_t len)
+{
+    // Standard data frame without stuff bits: 47 bits of overhead + payload.
+    if (_baud > 0)
+        Sim::advanceUs((uint64_t)(47 + 8 * len) * 1000000 / (uint64_t)_baud);
+}
+
+void Adafruit_MCP2515::deliver(const Sim::CanFrame &frame)
+{
+    if (_mode != Mode::Normal && _mode != Mode::ListenOnly)
+        return;
+    if ((uint32_t)_baud != Sim::busBitrate())
+    {
+        _rxError();
+        return;
+    }
+    _receive(frame);
+}
+
+void Adafruit_MCP2515::_rxError()
+{
+    _rxErrors++;
+    _errorIntf |= kIntfMerrf;
+    if (_mode != Mode::Normal || _rec == 255)
+        return;
+    _rec++;
+    uint8_t eflg = _eflg;
+    if (_rec >= 96)
+        _eflg |= kEflgEwarn | kEflgRxwar;
+    if (_rec >= 128)
+        _eflg |= kEflgRxep;
+    if (_eflg != eflg)
+        _errorIntf |= kIntfErrif;
+}
+
+uint8_t Adafruit_MCP2515::spiTransfer(uint8_t index, uint8_t out)
+{
+    if (index == 0)
+    {
+        _spiInstruction = out;
+        _spi(1);
+        if (out == kInstrReset)
+            _reset();
+        else if ((out & kInstrReadRxMask) == kInstrReadRx)
+            _stageRxBuffer((out >> 2) & 1, (out >> 1) & 1);
+        return 0;
+    }
+    if ((_spiInstruction & kInstrReadRxMask) == kInstrReadRx)
+        return index - 1 < (int)sizeof(_rxStage) ? _rxStage[index - 1] : 0;
+    if (index == 1)
+    {
+        _spiAddress = out;
+        return 0;
+    }
+    if (_spiInstruction == kInstrRead)
+        return _readRegister(_spiAddress++); // sequential read
+    if (_spiInstruction == kInstrWrite)
+        _writeRegister(_spiAddress++, out);
+    if (_spiInstruction == kInstrBitModify)
+    {
+        if (index == 2)
+            _spiMask = out;
+        else if (index == 3)
+            _modifyRegister(_spiAddress, _spiMask, out);
+    }
+    return 0;
+}
+
+uint8_t Adafruit_MCP2515::_readRegister(uint8_t address) const
+{
+    switch (address)
+    {
+    case kRegRec:
+        return _rec;
+    case kRegCanintf:
+        return _errorIntf | (_rxCount >= 1 ? 0x01 : 0) | (_rxCount >= 2 ? 0x02 : 0);
+    case kRegEflg:
+        return _eflg;
+    case kRegCanstat:
+    case kRegCanctrl:
+        return _opmod();
+    default:
+        return 0;
+    }
+}
+
+void Adafruit_MCP2515::_writeRegister(uint8_t address, uint8_t value)
+{
+    if (address >= kRegCnf3 && address <= kRegCnf1 && _mode == Mode::Config)
+    {
+        _cnf[kRegCnf1 - address] = value;
+    }
+    else if (address == kRegCanctrl)
+    {
+        Mode mode;
+        switch (value & 0xE0)
+        {
+        case 0x00:
+            mode = Mode::Normal;
+            break;
+        case 0x20:
+            mode = Mode::Sleep;
+            break;
+        case 0x40:
+            mode = Mode::Loopback;
+            break;
+        case 0x60:
+            mode = Mode::ListenOnly;
+            break;
+        default:
+            mode = Mode::Config;
+            break;
+        }
+        if (_mode == Mode::Config && mode != Mode::Config)
+        {
+            // Leaving configuration mode latches the bit timing.
+            _baud = 0;
+            for (const Timing &t : kTimings)
+            {
+                if (memcmp(t.cnf, _cnf, sizeof(_cnf)) == 0)
+                    _baud = t.baud;
+            }
+        }
+        if (mode == Mode::ListenOnly)
+        {
+            _rec = 0; // error counters are off in listen-only
+            _eflg &= kEflgOverflow;
+        }
+        _mode = mode;
+    }
+}
+
+uint8_t Adafruit_MCP2515::_opmod() const
+{
+    switch (_mode)
+    {
+    case Mode::Normal:
+        return 0x00;
+    case Mode::Sleep:
+        return 0x20;
+    case Mode::Loopback:
+        return 0x40;
+    case Mode::ListenOnly:
+        return 0x60;
+    default:
+        return 0x80;
+    }
+}
+
+void Adafruit_MCP2515::_reset()
+{
+    // Configuration mode; masks, filters, timing and flags all cleared.
+    _mode = Mode::Config;
+    _baud = 0;
+    memset(_cnf, 0, sizeof(_cnf));
+    memset(_masks, 0, sizeof(_masks));
+    memset(_filters, 0, sizeof(_filters));
+    _rxCount = 0;
+    _errorIntf = _eflg = _rec = 0;
+}
+
+void Adafruit_MCP2515::_stageRxBuffer(uint8_t buffer, bool fromData)
+{
+    memset(_rxStage, 0, sizeof(_rxStage));
+    if (buffer >= _rxCount)
+        return;
+    const Sim::CanFrame &f = _rxBuf[buffer];
+    uint8_t raw[13] = {(uint8_t)(f.id >> 3), (uint8_t)((f.id & 0x07) << 5 | (f.rtr ? 0x10 : 0)), 0, 0,
+                       (uint8_t)(f.len & 0x0F)};
+    memcpy(raw + 5, f.data, 8);
+    memcpy(_rxStage, raw + (fromData ? 5 : 0), fromData ? 8 : 13);
+    // Raising CS after READ RX BUFFER clears the buffer's RXnIF.
+    if (buffer == 0)
+        _rxBuf[0] = _rxBuf[1];
+    _rxCount--;
+}
+
+void Adafruit_MCP2515::_modifyRegister(uint8_t address, uint8_t mask, uint8_t value)
+{
+    // Receive flags belong to the driver; only the error bits are modelled.
+    if (address == kRegCanintf)
+    {
+        mask &= kIntfMerrf | kIntfErrif;
+        _errorIntf = (uint8_t)((_errorIntf & ~mask) | (value & mask));
+    }
+    else if (address == kRegEflg)
+    {
+        mask &= kEflgOverflow;
+        _eflg = (uint8_t)((_eflg & ~mask) | (value & mask));
+    }
+}
+
+void Adafruit_MCP2515::_receive(const Sim::CanFrame &frame)
+{
+    if (frame.extended || !_accepts(frame.id))
+        return;
+    if (_rxCount >= 2)
+    {
+        if (!(_eflg & kEflgRx1ovr))
+            _errorIntf |= kIntfErrif;
+        _eflg |= kEflgRx1ovr;
+        Sim::detail::countRx(false);
+        return;
+    }
+    _rxBuf[_rxCount++] = frame;
+    Sim::detail::countRx(true);
+}
+
+bool Adafruit_MCP2515::_accepts(uint32_t id) const
+{
+    // RXB0: mask 0 with filters 0-1, RXB1: mask 1 with filters 2-5.
+    for (uint8_t f = 0; f < 6; ++f)
+    {
+        uint32_t mask = _masks[f < 2 ? 0 : 1];
+        if (((id ^ _filters[f]) & mask) == 0)
+            return true;
+    }
+    return false;
+}
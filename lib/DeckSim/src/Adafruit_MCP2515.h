@@ -0,0 +1,106 @@
+// Fake Adafruit_MCP2515 for the host simulator. Mirrors the public API of the
+// driver (including the acceptance mask/filter extension) and models the
+// controller's modes, mask/filter matching and two receive buffers. Direct
+// SPI access decodes RESET, READ, WRITE, BIT MODIFY and READ RX BUFFER, enough
+// for a controller set up without the driver (CNF1-3 and CANCTRL) and for the
+// error registers: a frame at the wrong bitrate sets MERRF, and in normal
+// mode also counts towards REC and the EFLG warning/passive bits (the
+// counters are off in listen-only).
+#pragma once
+
+#include <Arduino.h>
+
+class Adafruit_MCP2515 : public Print, private Sim::detail::Controller
+{
+public:
+    explicit Adafruit_MCP2515(int8_t csPin);
+    ~Adafruit_MCP2515() override;
+
+    int begin(long baudRate);
+    void end();
+
+    int beginPacket(int id, int dlc = -1, bool rtr = false);
+    int beginExtendedPacket(long id, int dlc = -1, bool rtr = false);
+    int endPacket();
+
+    int parsePacket();
+    long packetId() const { return _rxValid ? (long)_rx.id : -1; }
+    bool packetExtended() const { return _rx.extended; }
+    bool packetRtr() const { return _rx.rtr; }
+    int packetDlc() const { return _rx.len; }
+
+    int available() { return _rxIndex < _rxLength ? _rxLength - _rxIndex : 0; }
+    int read() { return available() ? _rx.data[_rxIndex++] : -1; }
+    int peek() { return available() ? _rx.data[_rxIndex] : -1; }
+
+    using Print::write;
+    size_t write(uint8_t byte) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+
+    int observe();  // listen-only mode
+    int loopback(); // internal loopback mode
+    int sleep();
+    int wakeup();
+
+    bool setFilterMask(uint8_t mask, bool extended, uint32_t value);
+    bool setFilter(uint8_t filter, bool extended, uint32_t value);
+
+    // Simulator extension: receive error counter (frames seen on the bus at a
+    // different bitrate than the controller was configured for).
+    uint32_t simRxErrors() const { return _rxErrors; }
+
+private:
+    enum class Mode : uint8_t
+    {
+        Config,
+        Normal,
+        ListenOnly,
+        Loopback,
+        Sleep
+    };
+
+    // Bus timing model: every register access is a 3-byte SPI transfer at the
+    // driver's 10 MHz clock plus chip-select overhead, and endPacket() waits
+    // for the frame to leave the controller as the real driver does.
+    static constexpr uint32_t kRegisterAccessNs = 3 * 800 + 1000;
+    void _spi(uint16_t registerAccesses);
+    void _wire(uint8_t len);
+
+    void deliver(const Sim::CanFrame &frame) override;
+    uint8_t spiTransfer(uint8_t index, uint8_t out) override;
+    uint8_t _readRegister(uint8_t address) const;
+    void _writeRegister(uint8_t address, uint8_t value);
+    void _modifyRegister(uint8_t address, uint8_t mask, uint8_t value);
+    uint8_t _opmod() const;
+    void _reset();
+    void _stageRxBuffer(uint8_t buffer, bool fromData);
+    void _rxError();
+    void _receive(const Sim::CanFrame &frame);
+    bool _accepts(uint32_t id) const;
+
+    Mode _mode = Mode::Config;
+    long _baud = 0;
+    uint32_t _masks[2] = {0, 0};
+    uint32_t _filters[6] = {0, 0, 0, 0, 0, 0};
+    uint32_t _rxErrors = 0;
+    uint32_t _pendingNs = 0;
+
+    uint8_t _errorIntf = 0; // CANINTF error bits (MERRF, ERRIF)
+    uint8_t _eflg = 0;
+    uint8_t _rec = 0;
+    uint8_t _spiInstruction = 0;
+    uint8_t _spiAddress = 0;
+    uint8_t _spiMask = 0;
+    uint8_t _cnf[3] = {0, 0, 0}; // CNF1, CNF2, CNF3
+    uint8_t _rxStage[13] = {0};  // READ RX BUFFER contents being clocked out
+
+    Sim::CanFrame _rxBuf[2];
+    uint8_t _rxCount = 0;
+    Sim::CanFrame _rx;
+    bool _rxValid = false;
+    int _rxIndex = 0;
+    int _rxLength = 0;
+
+    Sim::CanFrame _tx;
+    bool _txActive = false;
+};
@@ -0,0 +1,54 @@
+// Fake Adafruit_NeoKey_1x4 for the host simulator. Keys come from the Sim
+// input state; each board that is begun claims the next four global indices.
+// Buttons are seesaw GPIO 4-7, active low, as on the real board.
+#pragma once
+
+#include "Adafruit_seesaw.h"
+#include "seesaw_neopixel.h"
+
+#define NEOKEY_1X4_ADDR 0x30
+#define NEOKEY_1X4_BUTTONA 4
+#define NEOKEY_1X4_BUTTONMASK ((1 << 4) | (1 << 5) | (1 << 6) | (1 << 7))
+
+class Adafruit_NeoKey_1x4 : public Adafruit_seesaw
+{
+public:
+    Adafruit_NeoKey_1x4(uint8_t addr = NEOKEY_1X4_ADDR) : pixels(4, 3, NEO_GRB + NEO_KHZ800) { _addr = addr; }
+
+    bool begin(uint8_t addr = NEOKEY_1X4_ADDR, int8_t flow = -1)
+    {
+        if (!Adafruit_seesaw::begin(addr, flow))
+            return false;
+        _board = Sim::detail::registerKeyBoard(addr);
+        return pixels.begin(addr);
+    }
+
+    uint8_t read()
+    {
+        uint8_t buf[4];
+        Adafruit_seesaw::read(SEESAW_GPIO_BASE, SEESAW_GPIO_BULK, buf, 4);
+        uint32_t gpio = ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+        return (uint8_t)(((~gpio) & NEOKEY_1X4_BUTTONMASK) >> NEOKEY_1X4_BUTTONA);
+    }
+
+    seesaw_NeoPixel pixels;
+
+protected:
+    void registerRead(uint8_t regHigh, uint8_t regLow, uint8_t *buf, size_t len) override
+    {
+        uint32_t gpio = 0xFFFFFFFF;
+        if (regHigh == SEESAW_GPIO_BASE && regLow == SEESAW_GPIO_BULK)
+        {
+            for (uint8_t i = 0; i < 4; ++i)
+            {
+                if (Sim::keyPressed((uint8_t)(_board * 4 + i)))
+                    gpio &= ~(1UL << (NEOKEY_1X4_BUTTONA + i));
+            }
+        }
+        for (size_t i = 0; i < len; ++i)
+            buf[i] = i < 4 ? (uint8_t)(gpio >> (24 - 8 * i)) : 0;
+    }
+
+private:
+    uint8_t _board = 0;
+};
@@ -0,0 +1,27 @@
+// Fake Adafruit_NeoPixel for the host simulator.
+#pragma once
+
+#include <stdio.h>
+#include "SimPixelStrip.h"
+
+class Adafruit_NeoPixel : public SimPixelStrip
+{
+public:
+    Adafruit_NeoPixel(uint16_t n, int16_t pin = 6, uint16_t type = NEO_GRB + NEO_KHZ800)
+        : SimPixelStrip(n)
+    {
+        (void)type;
+        setPin(pin);
+    }
+    Adafruit_NeoPixel() : SimPixelStrip(0) { setPin(-1); }
+
+    void begin() {}
+    void updateType(uint16_t type) { (void)type; }
+    void setPin(int16_t pin)
+    {
+        char name[20];
+        snprintf(name, sizeof(name), "neopixel@%d", pin);
+        _device = name;
+    }
+    bool canShow() const { return true; }
+};
@@ -0,0 +1,103 @@
+// Fake Adafruit_seesaw for the host simulator (rotary encoder board, and the
+// register transfers the NeoKey driver uses). I2C transfers charge virtual
+// time as a 100 kHz bus would.
+#pragma once
+
+#include <Arduino.h>
+
+#define SEESAW_GPIO_BASE 0x01
+#define SEESAW_GPIO_BULK 0x04
+
+class Adafruit_seesaw;
+
+// One register pointer per device address, shared by every driver object on
+// it: the NeoKey's GPIO reads and its seesaw_NeoPixel writes move the same
+// pointer, as on the real chip.
+inline uint8_t *seesawLatch(uint8_t addr)
+{
+    static uint8_t latches[128][8];
+    return latches[addr & 0x7F];
+}
+
+// Only a plain read of what the last pointer write latched.
+class Adafruit_I2CDevice
+{
+public:
+    explicit Adafruit_I2CDevice(Adafruit_seesaw *owner) : _owner(owner) {}
+    bool read(uint8_t *buffer, size_t len, bool stop = true);
+
+private:
+    Adafruit_seesaw *_owner;
+};
+
+class Adafruit_seesaw
+{
+public:
+    static constexpr uint32_t kI2cByteUs = 90; // 9 bit times at 100 kHz
+    static constexpr size_t kLatchSize = 8;
+
+    Adafruit_seesaw() = default;
+    Adafruit_seesaw(const Adafruit_seesaw &) = delete;
+    Adafruit_seesaw &operator=(const Adafruit_seesaw &) = delete;
+    virtual ~Adafruit_seesaw() = default;
+
+    bool begin(uint8_t addr = 0x49, int8_t flow = -1, bool reset = true)
+    {
+        (void)flow;
+        (void)reset;
+        _addr = addr;
+        return true;
+    }
+
+    uint32_t getVersion() { return (uint32_t)4991 << 16; }
+    void pinMode(uint8_t, uint8_t) {}
+    // Only the encoder push switch is modelled; it is active low.
+    bool digitalRead(uint8_t) { return !Sim::detail::encoderButton(); }
+    int32_t getEncoderPosition(uint8_t encoder = 0)
+    {
+        (void)encoder;
+        return Sim::detail::encoderPosition();
+    }
+    void setGPIOInterrupts(uint32_t, bool) {}
+    void enableEncoderInterrupt(uint8_t encoder = 0) { (void)encoder; }
+
+    bool write(uint8_t regHigh, uint8_t regLow, uint8_t *buf = nullptr, uint8_t num = 0)
+    {
+        (void)buf;
+        // The device samples the selected register when the pointer is set.
+        registerRead(regHigh, regLow, seesawLatch(_addr), kLatchSize);
+        Sim::advanceUs((3 + num) * kI2cByteUs); // address + register + payload
+        return true;
+    }
+
+    // Pointer write, conversion wait, then the read (what the library does).
+    bool read(uint8_t regHigh, uint8_t regLow, uint8_t *buf, uint8_t num, uint16_t delay = 250)
+    {
+        write(regHigh, regLow);
+        delayMicroseconds(delay);
+        return _i2c_dev->read(buf, num);
+    }
+
+protected:
+    friend class Adafruit_I2CDevice;
+    virtual void registerRead(uint8_t regHigh, uint8_t regLow, uint8_t *buf, size_t len)
+    {
+        (void)regHigh;
+        (void)regLow;
+        memset(buf, 0, len);
+    }
+
+    uint8_t _addr = 0;
+    Adafruit_I2CDevice _dev{this};
+    Adafruit_I2CDevice *_i2c_dev = &_dev;
+};
+
+inline bool Adafruit_I2CDevice::read(uint8_t *buffer, size_t len, bool stop)
+{
+    (void)stop;
+    Sim::advanceUs((1 + len) * Adafruit_seesaw::kI2cByteUs);
+    const uint8_t *latch = seesawLatch(_owner->_addr);
+    for (size_t i = 0; i < len; ++i)
+        buffer[i] = i < Adafruit_seesaw::kLatchSize ? latch[i] : 0;
+    return true;
+}
@@ -0,0 +1,131 @@
+// Minimal Arduino core for the host simulator. Time comes from the Sim
+// virtual clock; Serial output goes to stdout and input is scripted.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "Sim.h"
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+// Adafruit Feather RP2040 CAN variant pins
+#ifndef PIN_CAN_CS
+#define PIN_CAN_CS 19
+#endif
+#ifndef PIN_CAN_INTERRUPT
+#define PIN_CAN_INTERRUPT 22
+#endif
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+#define PROGMEM
+
+inline unsigned long millis() { return (unsigned long)(Sim::nowUs() / 1000); }
+inline unsigned long micros() { return (unsigned long)Sim::nowUs(); }
+// Advances in 1 ms slices so scripted input keeps its timing during long delays.
+inline void delay(unsigned long ms)
+{
+    while (ms--)
+        Sim::advanceUs(1000);
+}
+inline void delayMicroseconds(unsigned int us) { Sim::advanceUs(us); }
+inline void yield() {}
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+inline int digitalRead(uint8_t) { return LOW; }
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+class Print
+{
+public:
+    virtual ~Print() = default;
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buf, size_t size)
+    {
+        size_t n = 0;
+        while (size--)
+            n += write(*buf++);
+        return n;
+    }
+
+    size_t print(const __FlashStringHelper *s) { return print(reinterpret_cast<const char *>(s)); }
+    size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char v, int base = DEC) { return print((unsigned long long)v, base); }
+    size_t print(int v, int base = DEC) { return print((long long)v, base); }
+    size_t print(unsigned int v, int base = DEC) { return print((unsigned long long)v, base); }
+    size_t print(long v, int base = DEC) { return print((long long)v, base); }
+    size_t print(unsigned long v, int base = DEC) { return print((unsigned long long)v, base); }
+    size_t print(long long v, int base = DEC)
+    {
+        if (v < 0 && base == DEC)
+            return print('-') + print((unsigned long long)(-v), base);
+        return print((unsigned long long)v, base);
+    }
+    size_t print(unsigned long long v, int base = DEC)
+    {
+        char buf[66];
+        char *p = &buf[sizeof(buf) - 1];
+        *p = '\0';
+        if (base < 2)
+            base = 10;
+        do
+        {
+            unsigned d = (unsigned)(v % (unsigned)base);
+            *--p = (char)(d < 10 ? '0' + d : 'A' + d - 10);
+            v /= (unsigned)base;
+        } while (v);
+        return print(p);
+    }
+    size_t print(double v, int digits = 2)
+    {
+        char buf[48];
+        snprintf(buf, sizeof(buf), "%.*f", digits, v);
+        return print(buf);
+    }
+
+    size_t println() { return print("\r\n"); }
+    template <typename T>
+    size_t println(T v) { return print(v) + println(); }
+    template <typename T>
+    size_t println(T v, int base) { return print(v, base) + println(); }
+};
+
+class SimSerial : public Print
+{
+public:
+    void begin(unsigned long) {}
+    explicit operator bool() const { return true; }
+    int available() { return Sim::detail::serialAvailable(); }
+    int read() { return Sim::detail::serialRead(); }
+    int peek() { return Sim::detail::serialPeek(); }
+    void flush() {}
+
+    // Output is muted with --quiet so long runs are not I/O bound.
+    void setMuted(bool muted) { _muted = muted; }
+
+    using Print::write;
+    size_t write(uint8_t c) override;
+
+private:
+    bool _muted = false;
+};
+
+extern SimSerial Serial;
+
+void setup();
+void loop();
@@ -0,0 +1,46 @@
+#include "LittleFS.h"
+
+#include <sys/stat.h>
+
+SimLittleFS LittleFS;
+
+bool SimLittleFS::begin()
+{
+    struct stat st;
+    if (stat(_root.c_str(), &st) == 0)
+        return S_ISDIR(st.st_mode);
+    return mkdir(_root.c_str(), 0755) == 0;
+}
+
+std::string SimLittleFS::_path(const char *path) const
+{
+    std::string p = path ? path : "";
+    if (p.empty() || p[0] != '/')
+        p = "/" + p;
+    return _root + p;
+}
+
+File SimLittleFS::open(const char *path, const char *mode)
+{
+    std::string m = mode ? mode : "r";
+    if (m.find('b') == std::string::npos)
+        m += 'b';
+    FILE *f = fopen(_path(path).c_str(), m.c_str());
+    return f ? File(f, path) : File();
+}
+
+bool SimLittleFS::exists(const char *path)
+{
+    struct stat st;
+    return stat(_path(path).c_str(), &st) == 0;
+}
+
+bool SimLittleFS::remove(const char *path)
+{
+    return ::remove(_path(path).c_str()) == 0;
+}
+
+bool SimLittleFS::rename(const char *from, const char *to)
+{
+    return ::rename(_path(from).c_str(), _path(to).c_str()) == 0;
+}
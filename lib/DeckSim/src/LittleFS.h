@@ -0,0 +1,70 @@
+// Fake LittleFS for the host simulator, backed by a directory on the host
+// (./data by default, --fs DIR to change). Paths are absolute ("/trace.ocr").
+#pragma once
+
+#include <Arduino.h>
+#include <memory>
+#include <string>
+
+class File : public Print
+{
+public:
+    File() = default;
+    File(FILE *f, std::string name) : _f(f, fclose), _name(std::move(name)) {}
+
+    explicit operator bool() const { return (bool)_f; }
+
+    using Print::write;
+    size_t write(uint8_t c) override { return _f && fputc(c, _f.get()) != EOF ? 1 : 0; }
+    size_t write(const uint8_t *buf, size_t size) override { return _f ? fwrite(buf, 1, size, _f.get()) : 0; }
+
+    int read()
+    {
+        int c = _f ? fgetc(_f.get()) : EOF;
+        return c == EOF ? -1 : c;
+    }
+    size_t read(uint8_t *buf, size_t size) { return _f ? fread(buf, 1, size, _f.get()) : 0; }
+    int available() { return _f ? (int)(size() - position()) : 0; }
+    bool seek(uint32_t pos) { return _f && fseek(_f.get(), (long)pos, SEEK_SET) == 0; }
+    size_t position() const { return _f ? (size_t)ftell(_f.get()) : 0; }
+    size_t size() const
+    {
+        if (!_f)
+            return 0;
+        long cur = ftell(_f.get());
+        fseek(_f.get(), 0, SEEK_END);
+        long end = ftell(_f.get());
+        fseek(_f.get(), cur, SEEK_SET);
+        return (size_t)end;
+    }
+    void flush()
+    {
+        if (_f)
+            fflush(_f.get());
+    }
+    void close() { _f.reset(); }
+    const char *name() const { return _name.c_str(); }
+
+private:
+    std::shared_ptr<FILE> _f;
+    std::string _name;
+};
+
+class SimLittleFS
+{
+public:
+    bool begin();
+    void end() {}
+    File open(const char *path, const char *mode);
+    bool exists(const char *path);
+    bool remove(const char *path);
+    bool rename(const char *from, const char *to);
+
+    void setRoot(const std::string &root) { _root = root; }
+
+private:
+    std::string _path(const char *path) const;
+    std::string _root = "data";
+};
+
+extern SimLittleFS LittleFS;
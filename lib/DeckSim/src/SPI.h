@@ -0,0 +1,34 @@
+// Fake SPI for the host simulator. Bytes clocked within one transaction go
+// to the simulated MCP2515's instruction decoder, so register access that
+// bypasses the driver (e.g. reading EFLG) behaves as on the board.
+#pragma once
+
+#include <Arduino.h>
+
+#define MSBFIRST 1
+#define SPI_MODE0 0x00
+
+class SPISettings
+{
+public:
+    SPISettings(uint32_t clock = 4000000, uint8_t bitOrder = MSBFIRST, uint8_t dataMode = SPI_MODE0)
+    {
+        (void)clock;
+        (void)bitOrder;
+        (void)dataMode;
+    }
+};
+
+class SPIClass
+{
+public:
+    void begin() {}
+    void beginTransaction(SPISettings) { _index = 0; }
+    uint8_t transfer(uint8_t out) { return Sim::detail::spiTransfer(_index++, out); }
+    void endTransaction() {}
+
+private:
+    uint8_t _index = 0; // byte position within the transaction
+};
+
+inline SPIClass SPI;
@@ -0,0 +1,171 @@
+#include "Sim.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <thread>
+
+namespace Sim
+{
+    namespace
+    {
+        uint64_t g_nowUs = 0;
+        bool g_realTime = false;
+        std::chrono::steady_clock::time_point g_wallOrigin; // wall time at virtual 0
+
+        uint64_t wallUs()
+        {
+            return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - g_wallOrigin)
+                .count();
+        }
+        void (*g_timeHook)() = nullptr;
+        bool g_inTimeHook = false;
+        uint32_t g_busBitrate = 500000;
+        detail::Controller *g_controller = nullptr;
+        uint32_t g_rxOverruns = 0;
+        uint32_t g_rxDelivered = 0;
+
+        uint32_t g_keys = 0; // bit per global key index
+        uint8_t g_keyBoards = 0;
+        int32_t g_encoderPos = 0;
+        bool g_encoderButton = false;
+        std::deque<char> g_serialIn;
+
+        void (*g_txListener)(const CanFrame &) = nullptr;
+        std::vector<CanTxRecord> g_canTx;
+        std::vector<PixelRecord> g_pixels;
+    }
+
+    uint64_t nowUs()
+    {
+        if (g_realTime)
+            g_nowUs = std::max(g_nowUs, wallUs());
+        return g_nowUs;
+    }
+    void advanceUs(uint64_t us)
+    {
+        g_nowUs += us;
+        if (g_realTime)
+        {
+            uint64_t wall = wallUs();
+            if (wall < g_nowUs)
+                std::this_thread::sleep_for(std::chrono::microseconds(g_nowUs - wall));
+        }
+        if (g_timeHook && !g_inTimeHook)
+        {
+            g_inTimeHook = true;
+            g_timeHook();
+            g_inTimeHook = false;
+        }
+    }
+
+    void setTimeHook(void (*hook)()) { g_timeHook = hook; }
+    void resetClock() { g_nowUs = 0; }
+    void setRealTime(bool enabled)
+    {
+        g_realTime = enabled;
+        g_wallOrigin = std::chrono::steady_clock::now() - std::chrono::microseconds(g_nowUs);
+    }
+
+    void setBusBitrate(uint32_t bitrate) { g_busBitrate = bitrate; }
+    uint32_t busBitrate() { return g_busBitrate; }
+
+    void injectCanRx(const CanFrame &frame)
+    {
+        if (g_controller)
+            g_controller->deliver(frame);
+    }
+
+    uint32_t rxOverruns() { return g_rxOverruns; }
+    uint32_t rxDelivered() { return g_rxDelivered; }
+
+    void setKey(uint8_t index, bool pressed)
+    {
+        if (index >= 32)
+            return;
+        if (pressed)
+            g_keys |= (1UL << index);
+        else
+            g_keys &= ~(1UL << index);
+    }
+
+    bool keyPressed(uint8_t index) { return index < 32 && (g_keys & (1UL << index)); }
+    void moveEncoder(int32_t delta) { g_encoderPos += delta; }
+    void setEncoderButton(bool pressed) { g_encoderButton = pressed; }
+
+    void feedSerial(const std::string &text)
+    {
+        for (char c : text)
+            g_serialIn.push_back(c);
+    }
+
+    void setTxListener(void (*listener)(const CanFrame &frame)) { g_txListener = listener; }
+
+    const std::vector<CanTxRecord> &canTx() { return g_canTx; }
+    const std::vector<PixelRecord> &pixels() { return g_pixels; }
+
+    void clearRecords()
+    {
+        g_canTx.clear();
+        g_pixels.clear();
+    }
+
+    namespace detail
+    {
+        void attachController(Controller *c) { g_controller = c; }
+
+        void detachController(Controller *c)
+        {
+            if (g_controller == c)
+                g_controller = nullptr;
+        }
+
+        uint8_t spiTransfer(uint8_t index, uint8_t out)
+        {
+            return g_controller ? g_controller->spiTransfer(index, out) : 0xFF;
+        }
+
+        void recordTx(const CanFrame &frame)
+        {
+            g_canTx.push_back({nowUs(), frame});
+            if (g_txListener)
+                g_txListener(frame);
+        }
+
+        void recordPixel(const std::string &device, uint16_t index, uint32_t color)
+        {
+            g_pixels.push_back({nowUs(), device, index, color});
+        }
+
+        void countRx(bool delivered)
+        {
+            if (delivered)
+                g_rxDelivered++;
+            else
+                g_rxOverruns++;
+        }
+
+        uint8_t registerKeyBoard(uint8_t address)
+        {
+            (void)address;
+            return g_keyBoards++;
+        }
+
+        int32_t encoderPosition() { return g_encoderPos; }
+        bool encoderButton() { return g_encoderButton; }
+
+        int serialAvailable() { return (int)g_serialIn.size(); }
+
+        int serialRead()
+        {
+            if (g_serialIn.empty())
+                return -1;
+            char c = g_serialIn.front();
+            g_serialIn.pop_front();
+            return (uint8_t)c;
+        }
+
+        int serialPeek() { return g_serialIn.empty() ? -1 : (uint8_t)g_serialIn.front(); }
+    }
+}
@@ -0,0 +1,96 @@
+// Host-side simulation core for running the deck firmware on Linux.
+// Owns the virtual clock, the simulated CAN bus and key/encoder inputs, and
+// records every CAN transmit and pixel change with its virtual timestamp.
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Sim
+{
+    struct CanFrame
+    {
+        uint32_t id = 0;
+        bool extended = false;
+        bool rtr = false;
+        uint8_t len = 0;
+        uint8_t data[8] = {0};
+    };
+
+    struct CanTxRecord
+    {
+        uint64_t us;
+        CanFrame frame;
+    };
+
+    struct PixelRecord
+    {
+        uint64_t us;
+        std::string device; // e.g. "neokey@30", "encoder@36", "status"
+        uint16_t index;
+        uint32_t color; // 0x00RRGGBB as written by the firmware (pre-brightness)
+    };
+
+    // Virtual clock. millis()/micros()/delay() in the fake Arduino core read and
+    // advance this; nothing in the simulation ever looks at wall time unless
+    // real-time mode is on (needed with a real CAN interface): the clock then
+    // never runs behind the wall clock and advancing it sleeps.
+    uint64_t nowUs();
+    void advanceUs(uint64_t us);
+    void resetClock();
+    void setRealTime(bool enabled);
+    // Called after every clock advance, including delay() inside setup(), so
+    // scripted input keeps arriving while the firmware blocks.
+    void setTimeHook(void (*hook)());
+
+    // CAN bus. Frames injected here go through the fake MCP2515's mask/filter
+    // emulation and its two-slot receive buffer; anything arriving while both
+    // slots are full is dropped and counted as an overrun.
+    void setBusBitrate(uint32_t bitrate);
+    uint32_t busBitrate();
+    void injectCanRx(const CanFrame &frame);
+    uint32_t rxOverruns();
+    uint32_t rxDelivered();
+
+    // Inputs. Key index is global across chained NeoKey boards, in the order
+    // the boards were begun (board 0 owns keys 0-3, board 1 keys 4-7, ...).
+    void setKey(uint8_t index, bool pressed);
+    bool keyPressed(uint8_t index);
+    void moveEncoder(int32_t delta);
+    void setEncoderButton(bool pressed);
+    void feedSerial(const std::string &text);
+
+    // Called for every frame the firmware puts on the bus (e.g. to let a
+    // simulated ECU answer it).
+    void setTxListener(void (*listener)(const CanFrame &frame));
+
+    // Recorders.
+    const std::vector<CanTxRecord> &canTx();
+    const std::vector<PixelRecord> &pixels();
+    void clearRecords();
+
+    // Hooks used by the fake peripheral classes.
+    namespace detail
+    {
+        struct Controller
+        {
+            virtual ~Controller() = default;
+            virtual void deliver(const CanFrame &frame) = 0;
+            // One SPI byte; index is its position within the transaction.
+            virtual uint8_t spiTransfer(uint8_t index, uint8_t out) = 0;
+        };
+        void attachController(Controller *c);
+        void detachController(Controller *c);
+        uint8_t spiTransfer(uint8_t index, uint8_t out);
+        void recordTx(const CanFrame &frame);
+        void recordPixel(const std::string &device, uint16_t index, uint32_t color);
+        void countRx(bool delivered);
+        uint8_t registerKeyBoard(uint8_t address);
+        int32_t encoderPosition();
+        bool encoderButton();
+        int serialAvailable();
+        int serialRead();
+        int serialPeek();
+    }
+}
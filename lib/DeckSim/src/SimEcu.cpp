@@ -0,0 +1,214 @@
+#include "SimEcu.h"
+
+#include <algorithm>
+
+namespace Sim
+{
+    EcuBus &ecus()
+    {
+        static EcuBus bus;
+        return bus;
+    }
+
+    void EcuBus::addEcu(uint16_t reqId, uint16_t respId, uint8_t blockSize, uint8_t stMinMs)
+    {
+        Ecu e;
+        e.reqId = reqId;
+        e.respId = respId;
+        e.blockSize = blockSize;
+        e.stMinMs = stMinMs;
+        _ecus.push_back(e);
+    }
+
+    bool EcuBus::setDid(uint16_t reqId, uint16_t did, const std::vector<uint8_t> &data)
+    {
+        for (auto &e : _ecus)
+        {
+            if (e.reqId == reqId)
+            {
+                e.dids[did] = data;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void EcuBus::onTx(const CanFrame &frame)
+    {
+        if (frame.extended || frame.len < 1)
+            return;
+        for (auto &e : _ecus)
+        {
+            if (e.reqId != frame.id)
+                continue;
+            const uint8_t *d = frame.data;
+            uint64_t reply = nowUs() + kResponseDelayUs;
+            switch (d[0] >> 4)
+            {
+            case 0: // single frame
+            {
+                uint8_t len = d[0] & 0x0F;
+                if (len && len < frame.len)
+                    _request(e, std::vector<uint8_t>(d + 1, d + 1 + len));
+                break;
+            }
+            case 1: // first frame: answer with our flow control
+            {
+                if (frame.len < 8)
+                    break;
+                e.rxLen = (uint16_t)(((d[0] & 0x0F) << 8) | d[1]);
+                e.rx.assign(d + 2, d + 8);
+                e.rxSeq = 1;
+                e.rxBlockLeft = e.blockSize;
+                uint8_t fc[3] = {0x30, e.blockSize, e.stMinMs};
+                _queue(e, fc, 3, reply);
+                break;
+            }
+            case 2: // consecutive frame
+            {
+                if (!e.rxLen || (d[0] & 0x0F) != e.rxSeq)
+                {
+                    e.rxLen = 0;
+                    break;
+                }
+                size_t take = std::min<size_t>(7, e.rxLen - e.rx.size());
+                e.rx.insert(e.rx.end(), d + 1, d + 1 + take);
+                e.rxSeq = (e.rxSeq + 1) & 0x0F;
+                if (e.rx.size() >= e.rxLen)
+                {
+                    e.rxLen = 0;
+                    _request(e, e.rx);
+                }
+                else if (e.blockSize && --e.rxBlockLeft == 0)
+                {
+                    e.rxBlockLeft = e.blockSize;
+                    uint8_t fc[3] = {0x30, e.blockSize, e.stMinMs};
+                    _queue(e, fc, 3, reply);
+                }
+                break;
+            }
+            case 3: // flow control for our segmented response
+            {
+                if (!e.txWaitFc || frame.len < 3)
+                    break;
+                uint8_t status = d[0] & 0x0F;
+                if (status == 0)
+                {
+                    e.txWaitFc = false;
+                    _sendBlock(e, d[1], _stMinToUs(d[2]));
+                }
+                else if (status != 1)
+                {
+                    e.txWaitFc = false;
+                    e.tx.clear();
+                }
+                break;
+            }
+            }
+        }
+    }
+
+    void EcuBus::_request(Ecu &e, const std::vector<uint8_t> &req)
+    {
+        std::vector<uint8_t> resp;
+        uint8_t sid = req[0];
+        uint16_t did = req.size() >= 3 ? (uint16_t)((req[1] << 8) | req[2]) : 0;
+        if (sid == 0x22 && req.size() >= 3)
+        {
+            auto it = e.dids.find(did);
+            if (it != e.dids.end())
+            {
+                resp = {0x62, req[1], req[2]};
+                resp.insert(resp.end(), it->second.begin(), it->second.end());
+            }
+            else
+            {
+                resp = {0x7F, sid, 0x31}; // requestOutOfRange
+            }
+        }
+        else if (sid == 0x2E && req.size() >= 3)
+        {
+            e.dids[did].assign(req.begin() + 3, req.end());
+            resp = {0x6E, req[1], req[2]};
+        }
+        else
+        {
+            resp = {0x7F, sid, 0x11}; // serviceNotSupported
+        }
+        _respond(e, resp);
+    }
+
+    void EcuBus::_respond(Ecu &e, const std::vector<uint8_t> &resp)
+    {
+        uint64_t at = nowUs() + kResponseDelayUs;
+        if (resp.size() <= 7)
+        {
+            uint8_t sf[8] = {(uint8_t)resp.size()};
+            std::copy(resp.begin(), resp.end(), sf + 1);
+            _queue(e, sf, (uint8_t)(1 + resp.size()), at);
+            return;
+        }
+        uint8_t ff[8] = {(uint8_t)(0x10 | (resp.size() >> 8)), (uint8_t)(resp.size() & 0xFF)};
+        std::copy(resp.begin(), resp.begin() + 6, ff + 2);
+        _queue(e, ff, 8, at);
+        e.tx = resp;
+        e.txOffset = 6;
+        e.txSeq = 1;
+        e.txWaitFc = true;
+    }
+
+    void EcuBus::_sendBlock(Ecu &e, uint8_t blockSize, uint32_t stMinUs)
+    {
+        uint64_t at = nowUs() + 50; // ECU turnaround after flow control
+        for (uint8_t n = 0; e.txOffset < e.tx.size(); ++n)
+        {
+            if (blockSize && n == blockSize)
+            {
+                e.txWaitFc = true;
+                return;
+            }
+            uint8_t cf[8] = {(uint8_t)(0x20 | e.txSeq)};
+            size_t take = std::min<size_t>(7, e.tx.size() - e.txOffset);
+            std::copy(e.tx.begin() + e.txOffset, e.tx.begin() + e.txOffset + take, cf + 1);
+            e.txOffset += take;
+            e.txSeq = (e.txSeq + 1) & 0x0F;
+            _queue(e, cf, (uint8_t)(1 + take), at);
+            at = _busFreeUs + stMinUs;
+        }
+        e.tx.clear();
+    }
+
+    void EcuBus::_queue(const Ecu &e, const uint8_t *bytes, uint8_t len, uint64_t earliestUs)
+    {
+        Timed t;
+        t.frame.id = e.respId;
+        t.frame.len = 8; // padded, as most ECUs do
+        std::fill(t.frame.data, t.frame.data + 8, 0xAA);
+        std::copy(bytes, bytes + len, t.frame.data);
+
+        // One frame on the wire at a time: 47 bits of overhead plus 64 data bits.
+        uint64_t wireUs = (uint64_t)(47 + 64) * 1000000 / busBitrate();
+        uint64_t start = std::max(earliestUs, _busFreeUs);
+        t.atUs = start + wireUs; // received once the last bit is on the wire
+        _busFreeUs = t.atUs;
+        _pending.push_back(t);
+    }
+
+    void EcuBus::pump()
+    {
+        size_t n = 0;
+        while (n < _pending.size() && _pending[n].atUs <= nowUs())
+            injectCanRx(_pending[n++].frame);
+        if (n)
+            _pending.erase(_pending.begin(), _pending.begin() + n);
+    }
+
+    uint32_t EcuBus::_stMinToUs(uint8_t stMin)
+    {
+        if (stMin <= 0x7F)
+            return (uint32_t)stMin * 1000;
+        if (stMin >= 0xF1 && stMin <= 0xF9)
+            return (uint32_t)(stMin - 0xF0) * 100;
+        return 127000;
+    }
+}
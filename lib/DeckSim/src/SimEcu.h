@@ -0,0 +1,68 @@
+// Simulated diagnostic ECUs for the host simulator. Each ECU listens on a
+// request ID and answers UDS ReadDataByIdentifier (0x22) and
+// WriteDataByIdentifier (0x2E) over ISO-TP on its response ID, honouring the
+// tester's flow control and applying its own (block size, STmin) to
+// segmented requests. Replies are queued with bus timing and delivered as
+// virtual time advances.
+#pragma once
+
+#include "Sim.h"
+
+#include <map>
+#include <vector>
+
+namespace Sim
+{
+    class EcuBus
+    {
+    public:
+        static constexpr uint32_t kResponseDelayUs = 500; // request to first reply frame
+
+        void addEcu(uint16_t reqId, uint16_t respId, uint8_t blockSize, uint8_t stMinMs);
+        bool setDid(uint16_t reqId, uint16_t did, const std::vector<uint8_t> &data);
+
+        // Feed every frame the firmware transmits; deliver due replies.
+        void onTx(const CanFrame &frame);
+        void pump();
+
+    private:
+        struct Ecu
+        {
+            uint16_t reqId;
+            uint16_t respId;
+            uint8_t blockSize;
+            uint8_t stMinMs;
+            std::map<uint16_t, std::vector<uint8_t>> dids;
+
+            // Segmented request being received
+            std::vector<uint8_t> rx;
+            uint16_t rxLen = 0;
+            uint8_t rxSeq = 0;
+            uint8_t rxBlockLeft = 0;
+
+            // Segmented response being sent
+            std::vector<uint8_t> tx;
+            size_t txOffset = 0;
+            uint8_t txSeq = 0;
+            bool txWaitFc = false;
+        };
+
+        struct Timed
+        {
+            uint64_t atUs;
+            CanFrame frame;
+        };
+
+        void _request(Ecu &e, const std::vector<uint8_t> &req);
+        void _respond(Ecu &e, const std::vector<uint8_t> &resp);
+        void _sendBlock(Ecu &e, uint8_t blockSize, uint32_t stMinUs);
+        void _queue(const Ecu &e, const uint8_t *bytes, uint8_t len, uint64_t earliestUs);
+        static uint32_t _stMinToUs(uint8_t stMin);
+
+        std::vector<Ecu> _ecus;
+        std::vector<Timed> _pending; // ordered by atUs
+        uint64_t _busFreeUs = 0;
+    };
+
+    EcuBus &ecus();
+}
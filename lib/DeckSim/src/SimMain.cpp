@@ -0,0 +1,507 @@
+// Simulator entry point: runs the firmware's setup()/loop() against the fake
+// peripherals on a virtual clock, driven by a scenario script.
+//
+// Usage: deck_sim [--step-us N] [--duration-ms N] [--events FILE] [--fs DIR] [--warm] [--can IFACE] [--quiet] [scenario.txt]
+//
+// --fs sets the host directory that stands in for the LittleFS partition
+// (default ./data). Each run boots cold: the warm-start snapshot left by the
+// previous run is removed first, unless --warm keeps it.
+//
+// --can runs CANManager on a SocketCAN interface (e.g. vcan0) instead of the
+// simulated MCP2515, with the clock following wall time. Frames then come
+// from the interface (cangen, cansend, a replayed log), so scenario "rx"
+// lines and "expect tx" do not apply; transport statistics are printed at
+// the end (Ctrl-C stops the run). Linux only.
+//
+// Scenario lines are "<time_ms> <command> [args...]"; '#' starts a comment.
+// Times are absolute virtual milliseconds since boot. Prefix a command with
+// "every <period_ms> <until_ms>" to repeat it.
+//
+//   rx <id> [b0 b1 ...]              frame arrives on the bus (hex)
+//   key <n> down|up                  NeoKey key (global index)
+//   enc <delta>                      rotate the encoder
+//   encbtn down|up                   encoder push switch
+//   serial <text...>                 line typed on the serial console
+//   bitrate <bps>                    change the simulated bus bitrate
+//   ecu <req> <resp> [bs] [stmin_ms] add a UDS ECU (hex IDs) with its flow control
+//   ecu did <req> <did> <b0 b1 ...>  DID contents (hex bytes)
+//   ecu did <req> <did> ascii <text> DID contents as text
+//   ecu did <req> <did> fill <n>     DID of n bytes (0x00, 0x01, ...)
+//   expect tx <id> <within_ms>       a frame with <id> must be sent in time
+//   expect pixel <dev> <n> <within_ms> [rrggbb]
+//                                    pixel <n> of <dev> must change in time
+//   expect shows <dev> <n> <within_ms> <max>
+//                                    pixel <n> of <dev> is written (changed
+//                                    or not) at most <max> times in the window
+//   end                              stop the simulation
+//
+// Every pixel written by show() is recorded, including repeats of the same
+// colour. Events recorded by the run are written as CSV with --events;
+// expectations are checked at the end and the process exits non-zero if any
+// fail.
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "CANManager.h"
+#include "SimEcu.h"
+#ifdef __linux__
+#include "SocketCanTransport.h"
+#endif
+
+#include <cerrno>
+#include <csignal>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <queue>
+#include <sstream>
+#include <string>
+#include <vector>
+
+SimSerial Serial;
+
+size_t SimSerial::write(uint8_t c)
+{
+    if (!_muted)
+        fputc(c, stdout);
+    return 1;
+}
+
+// Unit tests (pio test -e native) link the fakes without the firmware and
+// bring their own main().
+#ifndef PIO_UNIT_TESTING
+
+extern CANManager g_can; // the firmware's instance (src/main.cpp)
+
+namespace
+{
+    struct Action
+    {
+        uint64_t atUs;
+        uint64_t periodUs;
+        uint64_t untilUs;
+        uint32_t seq;
+        int line;
+        std::vector<std::string> args;
+    };
+
+    struct ActionLater
+    {
+        bool operator()(const Action &a, const Action &b) const
+        {
+            return a.atUs != b.atUs ? a.atUs > b.atUs : a.seq > b.seq;
+        }
+    };
+
+    struct Expectation
+    {
+        uint64_t atUs;
+        uint64_t withinUs;
+        bool pixel;
+        bool shows; // count writes instead of waiting for a change
+        uint32_t maxShows;
+        uint32_t id;
+        std::string device;
+        uint16_t index;
+        bool hasColor;
+        uint32_t color;
+        int line;
+    };
+
+    uint64_t msToUs(const std::string &s) { return (uint64_t)(strtod(s.c_str(), nullptr) * 1000.0 + 0.5); }
+    uint32_t hex(const std::string &s) { return (uint32_t)strtoul(s.c_str(), nullptr, 16); }
+
+    // Print sink for the end-of-run summary, which --quiet does not mute.
+    struct StderrPrint : Print
+    {
+        using Print::write;
+        size_t write(uint8_t c) override { return fputc(c, stderr) == EOF ? 0 : 1; }
+    };
+
+    bool g_end = false;
+    volatile std::sig_atomic_t g_interrupted = 0; // Ctrl-C ends the run normally
+    bool g_ok = true;
+    std::vector<Expectation> g_expect;
+    std::priority_queue<Action, std::vector<Action>, ActionLater> g_actions;
+
+    bool fail(int line, const char *msg)
+    {
+        std::cerr << "[sim] scenario line " << line << ": " << msg << "\n";
+        return false;
+    }
+
+    bool apply(const Action &a)
+    {
+        const auto &v = a.args;
+        const std::string &cmd = v[0];
+        if (cmd == "rx" && v.size() >= 2)
+        {
+            Sim::CanFrame f;
+            f.id = hex(v[1]);
+            for (size_t i = 2; i < v.size() && f.len < 8; ++i)
+                f.data[f.len++] = (uint8_t)hex(v[i]);
+            Sim::injectCanRx(f);
+        }
+        else if (cmd == "key" && v.size() == 3)
+        {
+            Sim::setKey((uint8_t)atoi(v[1].c_str()), v[2] == "down");
+        }
+        else if (cmd == "enc" && v.size() == 2)
+        {
+            Sim::moveEncoder(atoi(v[1].c_str()));
+        }
+        else if (cmd == "encbtn" && v.size() == 2)
+        {
+            Sim::setEncoderButton(v[1] == "down");
+        }
+        else if (cmd == "serial")
+        {
+            std::string text;
+            for (size_t i = 1; i < v.size(); ++i)
+                text += (i > 1 ? " " : "") + v[i];
+            Sim::feedSerial(text + "\n");
+        }
+        else if (cmd == "bitrate" && v.size() == 2)
+        {
+            Sim::setBusBitrate((uint32_t)strtoul(v[1].c_str(), nullptr, 10));
+        }
+        else if (cmd == "ecu" && v.size() >= 5 && v[1] == "did")
+        {
+            std::vector<uint8_t> data;
+            if (v[4] == "ascii")
+            {
+                for (size_t i = 5; i < v.size(); ++i)
+                {
+                    if (i > 5)
+                        data.push_back(' ');
+                    data.insert(data.end(), v[i].begin(), v[i].end());
+                }
+            }
+            else if (v[4] == "fill" && v.size() == 6)
+            {
+                size_t n = strtoul(v[5].c_str(), nullptr, 10);
+                for (size_t i = 0; i < n; ++i)
+                    data.push_back((uint8_t)i);
+            }
+            else
+            {
+                for (size_t i = 4; i < v.size(); ++i)
+                    data.push_back((uint8_t)hex(v[i]));
+            }
+            if (!Sim::ecus().setDid((uint16_t)hex(v[2]), (uint16_t)hex(v[3]), data))
+                return fail(a.line, "no ECU with that request ID");
+        }
+        else if (cmd == "ecu" && v.size() >= 3 && v.size() <= 5)
+        {
+            uint8_t bs = v.size() >= 4 ? (uint8_t)atoi(v[3].c_str()) : 0;
+            uint8_t stMin = v.size() >= 5 ? (uint8_t)atoi(v[4].c_str()) : 0;
+            Sim::ecus().addEcu((uint16_t)hex(v[1]), (uint16_t)hex(v[2]), bs, stMin);
+        }
+        else if (cmd == "expect" && v.size() >= 4)
+        {
+            Expectation e{};
+            e.atUs = a.atUs;
+            e.line = a.line;
+            if (v[1] == "tx" && v.size() == 4)
+            {
+                e.id = hex(v[2]);
+                e.withinUs = msToUs(v[3]);
+            }
+            else if (v[1] == "pixel" && (v.size() == 5 || v.size() == 6))
+            {
+                e.pixel = true;
+                e.device = v[2];
+                e.index = (uint16_t)atoi(v[3].c_str());
+                e.withinUs = msToUs(v[4]);
+                e.hasColor = v.size() == 6;
+                e.color = e.hasColor ? hex(v[5]) : 0;
+            }
+            else if (v[1] == "shows" && v.size() == 6)
+            {
+                e.pixel = e.shows = true;
+                e.device = v[2];
+                e.index = (uint16_t)atoi(v[3].c_str());
+                e.withinUs = msToUs(v[4]);
+                e.maxShows = (uint32_t)strtoul(v[5].c_str(), nullptr, 10);
+            }
+            else
+            {
+                return fail(a.line, "bad expect");
+            }
+            g_expect.push_back(e);
+        }
+        else if (cmd == "end")
+        {
+            g_end = true;
+        }
+        else
+        {
+            return fail(a.line, "unknown command");
+        }
+        return true;
+    }
+
+    // Apply every scripted action that is due at the current virtual time.
+    void pumpActions()
+    {
+        Sim::ecus().pump();
+        while (!g_actions.empty() && g_actions.top().atUs <= Sim::nowUs())
+        {
+            Action a = g_actions.top();
+            g_actions.pop();
+            g_ok = apply(a) && g_ok;
+            if (a.periodUs && a.atUs + a.periodUs <= a.untilUs)
+            {
+                a.atUs += a.periodUs;
+                g_actions.push(a);
+            }
+        }
+    }
+
+    bool loadScenario(const char *path, uint64_t &lastUs)
+    {
+        std::ifstream in(path);
+        if (!in)
+        {
+            std::cerr << "[sim] cannot open " << path << "\n";
+            return false;
+        }
+        std::string line;
+        uint32_t seq = 0;
+        int lineNo = 0;
+        while (std::getline(in, line))
+        {
+            lineNo++;
+            size_t hash = line.find('#');
+            if (hash != std::string::npos)
+                line.erase(hash);
+            std::istringstream ss(line);
+            std::vector<std::string> tok;
+            std::string t;
+            while (ss >> t)
+                tok.push_back(t);
+            if (tok.size() < 2)
+                continue;
+
+            Action a{};
+            a.atUs = msToUs(tok[0]);
+            a.seq = seq++;
+            a.line = lineNo;
+            size_t first = 1;
+            if (tok[1] == "every")
+            {
+                if (tok.size() < 5 || msToUs(tok[2]) == 0)
+                    return fail(lineNo, "every needs <period_ms> <until_ms> <command>");
+                a.periodUs = msToUs(tok[2]);
+                a.untilUs = msToUs(tok[3]);
+                first = 4;
+            }
+            a.args.assign(tok.begin() + first, tok.end());
+            uint64_t last = a.periodUs ? a.untilUs : a.atUs;
+            if (last > lastUs)
+                lastUs = last;
+            g_actions.push(a);
+        }
+        return true;
+    }
+
+    bool checkExpectations()
+    {
+        bool ok = true;
+        for (const auto &e : g_expect)
+        {
+            int64_t hitUs = -1;
+            uint32_t shows = 0;
+            if (e.shows)
+            {
+                for (const auto &p : Sim::pixels())
+                {
+                    if (p.us >= e.atUs && p.us <= e.atUs + e.withinUs && p.device == e.device && p.index == e.index)
+                        shows++;
+                }
+                if (shows <= e.maxShows)
+                    hitUs = (int64_t)(e.atUs + e.withinUs);
+            }
+            else if (e.pixel)
+            {
+                // Only writes that change the pixel count; it starts off black.
+                uint32_t last = 0;
+                for (const auto &p : Sim::pixels())
+                {
+                    if (p.device != e.device || p.index != e.index)
+                        continue;
+                    bool changed = p.color != last;
+                    last = p.color;
+                    if (changed && p.us >= e.atUs && p.us <= e.atUs + e.withinUs && (!e.hasColor || p.color == e.color))
+                    {
+                        hitUs = (int64_t)p.us;
+                        break;
+                    }
+                }
+            }
+            else
+            {
+                for (const auto &t : Sim::canTx())
+                {
+                    if (t.us >= e.atUs && t.us <= e.atUs + e.withinUs && t.frame.id == e.id)
+                    {
+                        hitUs = (int64_t)t.us;
+                        break;
+                    }
+                }
+            }
+            std::cerr << "[sim] " << (hitUs >= 0 ? "PASS" : "FAIL") << " line " << e.line << ": ";
+            if (e.shows)
+            {
+                std::cerr << "shows " << e.device << "[" << e.index << "] " << shows << " (max " << e.maxShows
+                          << " in " << e.withinUs / 1000.0 << " ms)\n";
+                ok = ok && hitUs >= 0;
+                continue;
+            }
+            if (e.pixel)
+                std::cerr << "pixel " << e.device << "[" << e.index << "]";
+            else
+                std::cerr << "tx 0x" << std::hex << std::uppercase << e.id << std::dec;
+            if (hitUs >= 0)
+                std::cerr << " after " << (hitUs - (int64_t)e.atUs) / 1000.0 << " ms";
+            std::cerr << " (budget " << e.withinUs / 1000.0 << " ms)\n";
+            ok = ok && hitUs >= 0;
+        }
+        return ok;
+    }
+
+    void writeEvents(const char *path)
+    {
+        FILE *f = fopen(path, "w");
+        if (!f)
+        {
+            std::cerr << "[sim] cannot write " << path << "\n";
+            return;
+        }
+        fprintf(f, "us,kind,target,value\n");
+        size_t ti = 0, pi = 0;
+        const auto &tx = Sim::canTx();
+        const auto &px = Sim::pixels();
+        while (ti < tx.size() || pi < px.size())
+        {
+            bool takeTx = pi >= px.size() || (ti < tx.size() && tx[ti].us <= px[pi].us);
+            if (takeTx)
+            {
+                const auto &t = tx[ti++];
+                fprintf(f, "%llu,tx,%03X,", (unsigned long long)t.us, (unsigned)t.frame.id);
+                for (uint8_t i = 0; i < t.frame.len; ++i)
+                    fprintf(f, "%02X", t.frame.data[i]);
+                fputc('\n', f);
+            }
+            else
+            {
+                const auto &p = px[pi++];
+                fprintf(f, "%llu,pixel,%s[%u],%06X\n", (unsigned long long)p.us, p.device.c_str(), p.index, (unsigned)p.color);
+            }
+        }
+        fclose(f);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t stepUs = 100;
+    uint64_t durationUs = 0;
+    const char *eventsPath = nullptr;
+    const char *scenario = nullptr;
+    const char *canIface = nullptr;
+    bool warm = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--step-us" && i + 1 < argc)
+            stepUs = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--duration-ms" && i + 1 < argc)
+            durationUs = msToUs(argv[++i]);
+        else if (arg == "--events" && i + 1 < argc)
+            eventsPath = argv[++i];
+        else if (arg == "--fs" && i + 1 < argc)
+            LittleFS.setRoot(argv[++i]);
+        else if (arg == "--warm")
+            warm = true;
+        else if (arg == "--can" && i + 1 < argc)
+            canIface = argv[++i];
+        else if (arg == "--quiet")
+            Serial.setMuted(true);
+        else
+            scenario = argv[i];
+    }
+    if (stepUs == 0)
+        stepUs = 1;
+
+    if (!warm)
+    {
+        for (const char *path : WARM_START_PATHS)
+            LittleFS.remove(path);
+    }
+
+    uint64_t lastUs = 0;
+    if (scenario && !loadScenario(scenario, lastUs))
+        return 2;
+    if (!durationUs)
+        durationUs = lastUs + 1000000;
+
+#ifdef __linux__
+    std::unique_ptr<SocketCanTransport> socketCan;
+    if (canIface)
+    {
+        socketCan.reset(new SocketCanTransport(canIface));
+        if (!socketCan->begin(0))
+        {
+            std::cerr << "[sim] cannot open CAN interface " << canIface << ": " << strerror(errno) << "\n";
+            return 2;
+        }
+        g_can.setTransport(*socketCan);
+        Sim::setRealTime(true);
+    }
+#else
+    if (canIface)
+    {
+        std::cerr << "[sim] --can needs Linux (SocketCAN)\n";
+        return 2;
+    }
+#endif
+
+    auto wallStart = std::chrono::steady_clock::now();
+    uint64_t loops = 0;
+
+    Sim::setTimeHook(pumpActions);
+    Sim::setTxListener([](const Sim::CanFrame &f) { Sim::ecus().onTx(f); });
+    pumpActions();
+    setup();
+    std::signal(SIGINT, [](int) { g_interrupted = 1; });
+    while (!g_end && !g_interrupted && Sim::nowUs() < durationUs)
+    {
+        pumpActions();
+        loop();
+        loops++;
+        Sim::advanceUs(stepUs);
+    }
+
+    double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    double simS = Sim::nowUs() / 1e6;
+    std::cerr << "[sim] simulated " << simS << " s in " << wallS << " s wall (" << (wallS > 0 ? simS / wallS : 0)
+              << "x), " << loops << " loop() calls\n";
+    std::cerr << "[sim] CAN rx delivered=" << Sim::rxDelivered() << " overruns=" << Sim::rxOverruns()
+              << " tx=" << Sim::canTx().size() << " pixel writes=" << Sim::pixels().size() << "\n";
+
+    if (canIface)
+    {
+        StderrPrint err;
+        g_can.transport().printStats(err);
+    }
+
+    if (eventsPath)
+        writeEvents(eventsPath);
+    g_ok = checkExpectations() && g_ok;
+    return g_ok ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,60 @@
+// Shared pixel buffer for the fake NeoPixel classes. show() records every
+// pixel it pushes out, changed or not, so redundant shows stay visible;
+// scenario expectations filter for changes where they need to.
+#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "Sim.h"
+
+#ifndef NEO_GRB
+#define NEO_RGB ((0 << 6) | (0 << 4) | (1 << 2) | (2))
+#define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_KHZ800 0x0000
+#define NEO_KHZ400 0x0100
+#endif
+
+class SimPixelStrip
+{
+public:
+    explicit SimPixelStrip(uint16_t n) : _pixels(n, 0) {}
+
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b)
+    {
+        setPixelColor(n, Color(r, g, b));
+    }
+    void setPixelColor(uint16_t n, uint32_t c)
+    {
+        if (n < _pixels.size())
+            _pixels[n] = c & 0xFFFFFF;
+    }
+    uint32_t getPixelColor(uint16_t n) const { return n < _pixels.size() ? _pixels[n] : 0; }
+    uint16_t numPixels() const { return (uint16_t)_pixels.size(); }
+    void setBrightness(uint8_t b) { _brightness = b; }
+    uint8_t getBrightness() const { return _brightness; }
+    void clear()
+    {
+        for (auto &p : _pixels)
+            p = 0;
+    }
+    void updateLength(uint16_t n) { _pixels.assign(n, 0); }
+
+    void show()
+    {
+        for (uint16_t i = 0; i < _pixels.size(); ++i)
+            Sim::detail::recordPixel(_device, i, _pixels[i]);
+    }
+
+    static uint32_t Color(uint8_t r, uint8_t g, uint8_t b)
+    {
+        return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+    }
+
+protected:
+    std::string _device = "pixels";
+
+private:
+    std::vector<uint32_t> _pixels;
+    uint8_t _brightness = 255;
+};
@@ -0,0 +1,55 @@
+// Fake seesaw_NeoPixel for the host simulator. Every pixel transfer moves
+// the device's register pointer to the NeoPixel module, so a pending GPIO
+// read on the same board then returns pixel bytes instead of key state.
+#pragma once
+
+#include <stdio.h>
+#include "Adafruit_seesaw.h"
+#include "SimPixelStrip.h"
+
+class seesaw_NeoPixel : public SimPixelStrip
+{
+public:
+    seesaw_NeoPixel(uint16_t n, uint8_t p = 6, uint16_t t = NEO_GRB + NEO_KHZ800)
+        : SimPixelStrip(n)
+    {
+        (void)p;
+        (void)t;
+    }
+
+    bool begin(uint8_t addr = 0x49, int8_t flow = -1)
+    {
+        (void)flow;
+        char name[16];
+        snprintf(name, sizeof(name), "seesaw@%02X", addr);
+        _device = name;
+        _addr = addr;
+        return true;
+    }
+
+    void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b)
+    {
+        setPixelColor(n, Color(r, g, b));
+    }
+    void setPixelColor(uint16_t n, uint32_t c)
+    {
+        _movePointer();
+        SimPixelStrip::setPixelColor(n, c);
+    }
+    void clear()
+    {
+        _movePointer();
+        SimPixelStrip::clear();
+    }
+    void show()
+    {
+        _movePointer();
+        SimPixelStrip::show();
+    }
+
+private:
+    // NEOPIXEL_BUF/SHOW selected: reads now return what is not GPIO state.
+    void _movePointer() { memset(seesawLatch(_addr), 0, Adafruit_seesaw::kLatchSize); }
+
+    uint8_t _addr = 0;
+};
@@ -0,0 +1,63 @@
+#!/bin/sh
+# Receive throughput of the deck's CAN path (CANManager on SocketCanTransport,
+# run through deck_sim --can) against candump, both fed the same cangen burst
+# on a virtual CAN interface.
+#
+# Usage: lib/DeckSim/vcan_bench.sh [iface] [frames] [gap_ms]
+#
+# Needs can-utils, a built simulator (pio run -e native; override with
+# DECK_SIM=path) and a vcan interface:
+#   sudo modprobe vcan
+#   sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+#
+# Not yet run: the comparison against candump is still undelivered and no
+# reference numbers are recorded. The script prints them for the machine it
+# runs on. The deck's log is kept if it has no statistics.
+set -e
+
+IFACE=${1:-vcan0}
+FRAMES=${2:-100000}
+GAP_MS=${3:-0}
+DECK_SIM=${DECK_SIM:-.pio/build/native/program}
+ID=3F5 # one of the decoded IDs, so the deck's kernel filter passes it
+TMP=$(mktemp -d)
+KEEP=
+trap '[ -n "$KEEP" ] || rm -rf "$TMP"' EXIT
+
+now_ms() { date +%s%3N; }
+
+# Sends the burst; prints the elapsed milliseconds.
+burst()
+{
+    start=$(now_ms)
+    cangen "$IFACE" -I "$ID" -L 8 -D i -g "$GAP_MS" -n "$FRAMES"
+    echo $(($(now_ms) - start))
+}
+
+echo "Sending $FRAMES frames (ID $ID, gap $GAP_MS ms) on $IFACE"
+
+# candump baseline
+candump -d "$IFACE" >"$TMP/candump.log" 2>&1 &
+DUMP=$!
+sleep 0.5
+MS=$(burst)
+sleep 0.5
+kill "$DUMP"
+wait "$DUMP" 2>/dev/null || true
+GOT=$(grep -c "$IFACE" "$TMP/candump.log" || true)
+echo "candump: $GOT/$FRAMES frames, burst took $MS ms"
+grep DROPCOUNT "$TMP/candump.log" | tail -1 || true
+
+# Deck: setup() takes about 1.2 s; keep it running past the end of the burst.
+"$DECK_SIM" --quiet --can "$IFACE" --duration-ms 600000 >/dev/null 2>"$TMP/deck.log" &
+DECK=$!
+sleep 2
+MS=$(burst)
+sleep 0.5
+kill -INT "$DECK" 2>/dev/null || true
+wait "$DECK" 2>/dev/null || true
+echo "deck:    burst took $MS ms"
+if ! grep -A1 SocketCAN "$TMP/deck.log"; then
+    KEEP=1
+    echo "(no transport statistics, see $TMP/deck.log)"
+fi
@@ -0,0 +1,163 @@
+#include "CanBenchmark.h"
+
+void CanBenchmark::Stage::add(uint32_t us)
+{
+    totalUs += us;
+    if (us < minUs)
+        minUs = us;
+    if (us > maxUs)
+        maxUs = us;
+    count++;
+}
+
+bool CanBenchmark::run(CANManager &can, uint16_t frames, Result &out)
+{
+    out = Result{};
+    bool debugRaw = can.debugRaw();
+    bool debugDecoded = can.debugDecoded();
+    can.setDebugRaw(false);
+    can.setDebugDecoded(false);
+
+    if (!can.enterLoopback())
+    {
+        can.setDebugRaw(debugRaw);
+        can.setDebugDecoded(debugDecoded);
+        return false;
+    }
+
+    // The synthetic frames must not reach the sample consumer (history, rules,
+    // warm start) or the RX counters; both are put back after the run.
+    CANManager::SampleHandler sampleHandler = can.sampleHandler();
+    void *sampleHandlerCtx = can.sampleHandlerCtx();
+    CANManager::RxStatsSet rxStats = can.rxStats();
+    can.setSampleHandler(nullptr, nullptr);
+
+    // Discard anything still queued from the bus.
+    CANManager::Frame f;
+    while (can.fetchFrame(f))
+    {
+    }
+
+    uint32_t start = micros();
+    for (uint16_t i = 0; i < frames; ++i)
+    {
+        out.frames++;
+        // Alternate the two layouts so both decode paths are exercised, and
+        // walk every field through its range.
+        bool stalk = (i & 1) == 0;
+        CANManager::SCCMLeftStalkMsg sentStalk;
+        CANManager::FrontLightingMsg sentLighting;
+        uint32_t t0 = micros();
+        bool sent;
+        if (stalk)
+        {
+            sentStalk.leftStalkCounter = (uint8_t)(i & 0x0F);
+            sentStalk.highBeamStalkStatus = (CANManager::HighBeamStalkStatus)((i >> 1) & 0x03);
+            sentStalk.washWipeButtonStatus = (CANManager::WashWipeButtonStatus)((i >> 3) & 0x03);
+            sentStalk.turnIndicatorStalkStatus = (CANManager::TurnIndicatorStalkStatus)((i >> 1) % 6);
+            sent = can.sendSCCMLeftStalk(sentStalk);
+        }
+        else
+        {
+            sentLighting.indicatorLeftRequest = (CANManager::IndicatorReq)((i >> 1) & 0x03);
+            sentLighting.indicatorRightRequest = (CANManager::IndicatorReq)((i >> 3) & 0x03);
+            uint8_t data[8];
+            sent = CANManager::FrontLightingFrame::pack(sentLighting, data) &&
+                   can.sendFrame(CANManager::FrontLightingFrame::kId, data, CANManager::FrontLightingFrame::kDlc);
+        }
+        uint32_t t1 = micros();
+        out.tx.add(t1 - t0);
+        if (!sent)
+        {
+            out.lost++;
+            continue;
+        }
+
+        bool got;
+        uint32_t fetchStart;
+        do
+        {
+            fetchStart = micros();
+            got = can.fetchFrame(f);
+        } while (!got && fetchStart - t1 < kLoopbackTimeoutUs);
+        uint32_t t2 = micros();
+        if (!got)
+        {
+            out.lost++;
+            continue;
+        }
+        out.fetch.add(t2 - fetchStart);
+        out.turnaround.add(t2 - t1);
+
+        can.handleFrame(f);
+        out.decode.add(micros() - t2);
+        out.received++;
+
+        bool match;
+        if (stalk)
+        {
+            auto dec = can.getSCCMLeftStalk();
+            match = f.id == CANManager::SCCMLeftStalkFrame::kId &&
+                    dec.leftStalkCounter == sentStalk.leftStalkCounter &&
+                    dec.highBeamStalkStatus == sentStalk.highBeamStalkStatus &&
+                    dec.washWipeButtonStatus == sentStalk.washWipeButtonStatus &&
+                    dec.turnIndicatorStalkStatus == sentStalk.turnIndicatorStalkStatus;
+        }
+        else
+        {
+            auto dec = can.getFrontLighting();
+            match = f.id == CANManager::FrontLightingFrame::kId &&
+                    dec.indicatorLeftRequest == sentLighting.indicatorLeftRequest &&
+                    dec.indicatorRightRequest == sentLighting.indicatorRightRequest;
+        }
+        if (!match)
+            out.mismatches++;
+    }
+    out.elapsedUs = micros() - start;
+
+    can.resetDecoded();
+    can.setRxStats(rxStats);
+    can.setSampleHandler(sampleHandler, sampleHandlerCtx);
+    can.setDebugRaw(debugRaw);
+    can.setDebugDecoded(debugDecoded);
+    return can.begin(can.bitrate());
+}
+
+static void printStage(Print &out, const __FlashStringHelper *name, const CanBenchmark::Stage &s)
+{
+    out.print(F("  "));
+    out.print(name);
+    out.print(F(" avg="));
+    out.print(s.avgUs());
+    out.print(F(" min="));
+    out.print(s.count ? s.minUs : 0);
+    out.print(F(" max="));
+    out.print(s.maxUs);
+    out.println(F(" us"));
+}
+
+void CanBenchmark::print(Print &out, const Result &r)
+{
+    out.print(F("CAN loopback benchmark: "));
+    out.print(r.received);
+    out.print('/');
+    out.print(r.frames);
+    out.print(F(" frames in "));
+    out.print(r.elapsedUs);
+    out.print(F(" us"));
+    if (r.elapsedUs)
+    {
+        out.print(F(" -> "));
+        out.print((uint32_t)((uint64_t)r.received * 1000000 / r.elapsedUs));
+        out.print(F(" frames/s"));
+    }
+    out.println();
+    out.print(F("  lost="));
+    out.print(r.lost);
+    out.print(F(" mismatches="));
+    out.println(r.mismatches);
+    printStage(out, F("tx        "), r.tx);
+    printStage(out, F("fetch     "), r.fetch);
+    printStage(out, F("decode    "), r.decode);
+    printStage(out, F("turnaround"), r.turnaround);
+}
@@ -0,0 +1,154 @@
+#ifdef CAN_PROFILE
+
+#include "CanProfile.h"
+
+namespace CanProfile
+{
+#if defined(ARDUINO_ARCH_RP2040)
+    uint32_t g_reload = 0xFFFFFF;
+#endif
+
+    namespace
+    {
+        struct Counter
+        {
+            uint32_t min;
+            uint32_t max;
+            uint64_t total;
+            uint32_t count;
+        };
+
+        struct Entry
+        {
+            uint32_t id;
+            Counter stages[kStages];
+        };
+
+        Entry g_table[kMaxIds];
+        uint8_t g_used = 0;
+        uint8_t g_last = 0;     // most recent entry, checked first
+        uint32_t g_dropped = 0; // samples for IDs that did not fit
+
+        const char *const kStageNames[kStages] = {"fetch", "dispatch", "change", "extract", "notify", "tx"};
+    }
+
+    void begin()
+    {
+#if defined(ARDUINO_ARCH_RP2040)
+        // Free-running at the processor clock, no interrupt. Left alone if
+        // something else already runs it; elapsed() then uses its reload.
+        if (!(systick_hw->csr & 1))
+        {
+            systick_hw->rvr = 0xFFFFFF;
+            systick_hw->cvr = 0;
+            systick_hw->csr = 0x5; // ENABLE | CLKSOURCE (processor clock)
+        }
+        g_reload = systick_hw->rvr & 0xFFFFFF;
+#endif
+        reset();
+    }
+
+    void record(uint32_t id, Stage stage, uint32_t ticks)
+    {
+        Entry *e = nullptr;
+        if (g_used && g_table[g_last].id == id)
+        {
+            e = &g_table[g_last];
+        }
+        else
+        {
+            for (uint8_t i = 0; i < g_used; ++i)
+            {
+                if (g_table[i].id == id)
+                {
+                    e = &g_table[i];
+                    g_last = i;
+                    break;
+                }
+            }
+            if (!e)
+            {
+                if (g_used == kMaxIds)
+                {
+                    g_dropped++;
+                    return;
+                }
+                g_last = g_used++;
+                e = &g_table[g_last];
+                *e = Entry{};
+                e->id = id;
+            }
+        }
+
+        Counter &c = e->stages[stage];
+        if (!c.count || ticks < c.min)
+            c.min = ticks;
+        if (ticks > c.max)
+            c.max = ticks;
+        c.total += ticks;
+        c.count++;
+    }
+
+    void reset()
+    {
+        g_used = 0;
+        g_last = 0;
+        g_dropped = 0;
+    }
+
+    void print(Print &out)
+    {
+#if defined(ARDUINO_ARCH_RP2040)
+        out.print(F("CAN profile (cycles @ "));
+        out.print(F_CPU / 1000000);
+        out.print(F(" MHz"));
+        if (g_reload != 0xFFFFFF)
+        {
+            // SysTick was already running with a shorter period.
+            out.print(F(", laps over "));
+            out.print(g_reload + 1);
+            out.print(F(" alias"));
+        }
+        out.println(F(")"));
+#else
+        out.println(F("CAN profile (ns, host)"));
+#endif
+        out.println(F("ID     stage     count  min  avg  max"));
+        for (uint8_t i = 0; i < g_used; ++i)
+        {
+            const Entry &e = g_table[i];
+            for (uint8_t s = 0; s < kStages; ++s)
+            {
+                const Counter &c = e.stages[s];
+                if (!c.count)
+                    continue;
+                if (e.id == kIdle)
+                {
+                    out.print(F("idle "));
+                }
+                else
+                {
+                    out.print(F("0x"));
+                    out.print(e.id, HEX);
+                }
+                out.print(F("  "));
+                out.print(kStageNames[s]);
+                out.print(F("  "));
+                out.print(c.count);
+                out.print(F("  "));
+                out.print(c.min);
+                out.print(F("  "));
+                out.print((uint32_t)(c.total / c.count));
+                out.print(F("  "));
+                out.println(c.max);
+            }
+        }
+        if (g_dropped)
+        {
+            out.print(g_dropped);
+            out.println(F(" samples dropped (ID table full)"));
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,399 @@
+#include "CanReplay.h"
+
+static const uint8_t kMagic[4] = {'O', 'C', 'R', '1'};
+
+bool CanReplay::start(const char *path, uint16_t speedPercent, bool loop)
+{
+    stop();
+    _file = LittleFS.open(path, "r");
+    if (!_file)
+        return false;
+
+    uint8_t magic[4] = {0};
+    _binary = _file.read(magic, 4) == 4 && memcmp(magic, kMagic, 4) == 0;
+    if (!_binary)
+        _file.seek(0);
+
+    _speedPercent = speedPercent ? speedPercent : 100;
+    _loop = loop;
+    _eof = false;
+    _bufLen = _bufPos = 0;
+    _head = _count = 0;
+    _lastUs = _loopBaseUs = _passUs = 0;
+    _haveOrigin = false;
+    _passFrames = _passQueued = 0;
+    _stats = Stats{};
+    _active = true;
+
+    // Fill the ring before the clock starts so the first frames go out on time.
+    for (uint8_t i = 0; i < kPrefetch / kRefillPerService; ++i)
+        _refill();
+    _startUs = micros();
+    return true;
+}
+
+void CanReplay::stop()
+{
+    if (_file)
+        _file.close();
+    _active = false;
+}
+
+void CanReplay::setIdFilter(FilterMode mode, const uint16_t *ids, uint8_t count)
+{
+    _filterMode = mode;
+    _filterCount = 0;
+    for (uint8_t i = 0; i < count && i < kMaxIdFilters; ++i)
+        _filterIds[_filterCount++] = ids[i];
+}
+
+bool CanReplay::_passes(uint16_t id) const
+{
+    if (_filterMode == FilterMode::None)
+        return true;
+    bool listed = false;
+    for (uint8_t i = 0; i < _filterCount; ++i)
+        listed = listed || _filterIds[i] == id;
+    return _filterMode == FilterMode::Include ? listed : !listed;
+}
+
+void CanReplay::service()
+{
+    if (!_active)
+        return;
+    _refill();
+
+    uint32_t now = micros();
+    while (_count)
+    {
+        const Entry &e = _ring[_head];
+        uint32_t due = _startUs + (uint32_t)(e.traceUs * 100 / _speedPercent);
+        int32_t late = (int32_t)(now - due);
+        if (late < 0)
+            break;
+
+        if (_can.sendFrame(e.id, e.data, e.dlc))
+        {
+            _stats.sent++;
+            _stats.errTotalUs += (uint32_t)late;
+            if ((uint32_t)late > _stats.errMaxUs)
+                _stats.errMaxUs = (uint32_t)late;
+        }
+        else
+        {
+            _stats.failed++;
+        }
+        _head = (uint8_t)((_head + 1) % kPrefetch);
+        _count--;
+        now = micros();
+    }
+
+    if (!_count && _eof)
+    {
+        stop();
+        Serial.println(F("Replay finished"));
+        printStats(Serial);
+    }
+}
+
+void CanReplay::_refill()
+{
+    for (uint8_t n = 0; n < kRefillPerService && _count < kPrefetch && !_eof; ++n)
+    {
+        Entry &e = _ring[(_head + _count) % kPrefetch];
+        switch (_readRecord(e))
+        {
+        case ReadResult::Frame:
+            if (_passes(e.id))
+            {
+                _count++;
+                _passQueued++;
+            }
+            else
+                _stats.filtered++;
+            break;
+        case ReadResult::Skip:
+            _stats.skipped++;
+            break;
+        case ReadResult::End:
+            if (!_loop || !_rewind())
+                _eof = true;
+            break;
+        }
+    }
+}
+
+bool CanReplay::_rewind()
+{
+    // A pass that sent nothing (no usable frame, or all filtered out) would
+    // loop forever without output.
+    if (!_passQueued)
+        return false;
+    if (!_file.seek(_binary ? 4 : 0))
+        return false;
+    _bufLen = _bufPos = 0;
+    // The next pass starts one inter-frame gap after the last frame.
+    uint64_t gap = _passFrames > 1 ? _loopGapUs : kSingleFrameLoopUs;
+    _loopBaseUs = _lastUs + gap - _passFirstUs;
+    _passUs = 0;
+    _passFrames = _passQueued = 0;
+    _haveOrigin = false;
+    _stats.loops++;
+    return true;
+}
+
+CanReplay::ReadResult CanReplay::_readRecord(Entry &e)
+{
+    ReadResult r = _binary ? _readBinary(e) : _readText(e);
+    if (r == ReadResult::Frame)
+    {
+        e.traceUs = _loopBaseUs + _passUs;
+        _lastUs = e.traceUs;
+        if (!_passFrames)
+            _passFirstUs = _passUs;
+        else if (_passFrames == 1)
+            _loopGapUs = _passUs - _passFirstUs;
+        _passFrames++;
+    }
+    return r;
+}
+
+int CanReplay::_readByte()
+{
+    if (_bufPos >= _bufLen)
+    {
+        _bufLen = (uint8_t)_file.read(_buf, sizeof(_buf));
+        _bufPos = 0;
+        if (!_bufLen)
+            return -1;
+    }
+    return _buf[_bufPos++];
+}
+
+CanReplay::ReadResult CanReplay::_readBinary(Entry &e)
+{
+    uint64_t delta = 0;
+    for (uint8_t shift = 0;; shift += 7)
+    {
+        int c = _readByte();
+        if (c < 0 || shift > 56)
+            return ReadResult::End;
+        delta |= (uint64_t)(c & 0x7F) << shift;
+        if (!(c & 0x80))
+            break;
+    }
+    int hi = _readByte();
+    int lo = _readByte();
+    if (hi < 0 || lo < 0)
+        return ReadResult::End;
+    _passUs += delta;
+
+    bool rtr = hi & 0x80;
+    e.dlc = (uint8_t)((hi >> 3) & 0x0F);
+    e.id = (uint16_t)(((hi & 0x07) << 8) | lo);
+    if (e.dlc > 8)
+        return ReadResult::End; // corrupt; stop rather than misframe the rest
+    if (rtr)
+        return ReadResult::Skip;
+    for (uint8_t i = 0; i < e.dlc; ++i)
+    {
+        int c = _readByte();
+        if (c < 0)
+            return ReadResult::End;
+        e.data[i] = (uint8_t)c;
+    }
+    return ReadResult::Frame;
+}
+
+CanReplay::ReadResult CanReplay::_readText(Entry &e)
+{
+    char line[96];
+    uint8_t len = 0;
+    int c;
+    while ((c = _readByte()) >= 0 && c != '\n')
+    {
+        if (len < sizeof(line) - 1)
+            line[len++] = (char)c;
+    }
+    if (c < 0 && len == 0)
+        return ReadResult::End;
+    line[len] = '\0';
+
+    uint64_t ts;
+    uint32_t id;
+    bool ext, rtr;
+    if (!_parseCandumpLine(line, ts, id, ext, rtr, e.dlc, e.data) || ext || rtr)
+        return ReadResult::Skip;
+    if (!_haveOrigin)
+    {
+        _originUs = ts;
+        _haveOrigin = true;
+    }
+    _passUs = ts >= _originUs ? ts - _originUs : 0;
+    e.id = (uint16_t)id;
+    return ReadResult::Frame;
+}
+
+static int hexNibble(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+bool CanReplay::_parseCandumpLine(char *line, uint64_t &tsUs, uint32_t &id, bool &ext, bool &rtr, uint8_t &dlc, uint8_t *data)
+{
+    // (1436509052.249713) can0 123#DEADBEEF
+    char *p = line;
+    while (*p == ' ')
+        p++;
+    if (*p++ != '(')
+        return false;
+    uint64_t sec = 0;
+    while (*p >= '0' && *p <= '9')
+        sec = sec * 10 + (uint64_t)(*p++ - '0');
+    if (*p++ != '.')
+        return false;
+    uint32_t usec = 0;
+    uint8_t digits = 0;
+    while (*p >= '0' && *p <= '9')
+    {
+        if (digits < 6)
+        {
+            usec = usec * 10 + (uint32_t)(*p - '0');
+            digits++;
+        }
+        p++;
+    }
+    while (digits++ < 6)
+        usec *= 10;
+    if (*p++ != ')')
+        return false;
+    tsUs = sec * 1000000ULL + usec;
+
+    // Interface name
+    while (*p == ' ')
+        p++;
+    while (*p && *p != ' ')
+        p++;
+    while (*p == ' ')
+        p++;
+
+    // ID#DATA
+    char *hash = strchr(p, '#');
+    if (!hash || hash[1] == '#') // CAN FD is not supported
+        return false;
+    uint8_t idDigits = (uint8_t)(hash - p);
+    if (idDigits != 3 && idDigits != 8)
+        return false;
+    id = 0;
+    for (char *q = p; q < hash; ++q)
+    {
+        int n = hexNibble(*q);
+        if (n < 0)
+            return false;
+        id = (id << 4) | (uint32_t)n;
+    }
+    ext = idDigits == 8;
+
+    p = hash + 1;
+    rtr = *p == 'R';
+    dlc = 0;
+    if (rtr)
+        return true;
+    while (dlc < 8)
+    {
+        if (*p == '.')
+            p++;
+        int h = hexNibble(p[0]);
+        int l = h >= 0 ? hexNibble(p[1]) : -1;
+        if (h < 0 || l < 0)
+            break;
+        data[dlc++] = (uint8_t)((h << 4) | l);
+        p += 2;
+    }
+    return true;
+}
+
+bool CanReplay::convertCandump(const char *inPath, const char *outPath, uint32_t *frames)
+{
+    File in = LittleFS.open(inPath, "r");
+    if (!in)
+        return false;
+    File out = LittleFS.open(outPath, "w");
+    if (!out)
+        return false;
+    out.write(kMagic, 4);
+
+    uint32_t count = 0;
+    uint64_t prevUs = 0;
+    bool first = true;
+    char line[96];
+    while (in.available())
+    {
+        uint8_t len = 0;
+        int c;
+        while ((c = in.read()) >= 0 && c != '\n')
+        {
+            if (len < sizeof(line) - 1)
+                line[len++] = (char)c;
+        }
+        line[len] = '\0';
+
+        uint64_t ts;
+        uint32_t id;
+        bool ext, rtr;
+        uint8_t dlc;
+        uint8_t data[8];
+        if (!_parseCandumpLine(line, ts, id, ext, rtr, dlc, data) || ext)
+            continue;
+        uint64_t delta = first || ts < prevUs ? 0 : ts - prevUs;
+        prevUs = ts;
+        first = false;
+
+        uint8_t rec[10 + 2 + 8];
+        uint8_t n = 0;
+        do
+        {
+            uint8_t b = delta & 0x7F;
+            delta >>= 7;
+            rec[n++] = delta ? (uint8_t)(b | 0x80) : b;
+        } while (delta);
+        rec[n++] = (uint8_t)((rtr ? 0x80 : 0) | ((dlc & 0x0F) << 3) | ((id >> 8) & 0x07));
+        rec[n++] = (uint8_t)(id & 0xFF);
+        for (uint8_t i = 0; !rtr && i < dlc; ++i)
+            rec[n++] = data[i];
+        out.write(rec, n);
+        count++;
+    }
+    out.close();
+    in.close();
+    if (frames)
+        *frames = count;
+    return true;
+}
+
+void CanReplay::printStats(Print &out) const
+{
+    out.print(F("Replay: sent="));
+    out.print(_stats.sent);
+    out.print(F(" filtered="));
+    out.print(_stats.filtered);
+    out.print(F(" skipped="));
+    out.print(_stats.skipped);
+    out.print(F(" failed="));
+    out.print(_stats.failed);
+    out.print(F(" loops="));
+    out.println(_stats.loops);
+    out.print(F("  timing error vs trace: avg="));
+    out.print(_stats.sent ? (uint32_t)(_stats.errTotalUs / _stats.sent) : 0);
+    out.print(F(" us max="));
+    out.print(_stats.errMaxUs);
+    out.print(F(" us (speed "));
+    out.print(_speedPercent);
+    out.println(F("%)"));
+}
@@ -0,0 +1,325 @@
+#include "IsoTp.h"
+
+// Protocol control information, high nibble of byte 0
+static constexpr uint8_t PCI_SF = 0x00;
+static constexpr uint8_t PCI_FF = 0x10;
+static constexpr uint8_t PCI_CF = 0x20;
+static constexpr uint8_t PCI_FC = 0x30;
+
+// Flow status
+static constexpr uint8_t FC_CTS = 0;
+static constexpr uint8_t FC_WAIT = 1;
+static constexpr uint8_t FC_OVERFLOW = 2;
+
+void IsoTp::begin()
+{
+    _can.setFrameHandler(_onFrame, this);
+}
+
+int8_t IsoTp::open(uint16_t txId, uint16_t rxId, Handler handler, void *ctx)
+{
+    for (uint8_t i = 0; i < kMaxSessions; ++i)
+    {
+        // Replies are matched on the RX ID alone, so it must be unique.
+        if (_sessions[i].state != State::Closed && _sessions[i].rxId == rxId)
+            return -1;
+    }
+    for (uint8_t i = 0; i < kMaxSessions; ++i)
+    {
+        Session &s = _sessions[i];
+        if (s.state != State::Closed)
+            continue;
+        if (!_can.subscribe(rxId))
+            return -1;
+        s = Session{};
+        s.state = State::Idle;
+        s.txId = txId;
+        s.rxId = rxId;
+        s.handler = handler;
+        s.ctx = ctx;
+        return (int8_t)i;
+    }
+    return -1;
+}
+
+void IsoTp::close(uint8_t session)
+{
+    if (session >= kMaxSessions || _sessions[session].state == State::Closed)
+        return;
+    _can.unsubscribe(_sessions[session].rxId);
+    _sessions[session].state = State::Closed;
+}
+
+void IsoTp::setRxFlowControl(uint8_t session, uint8_t blockSize, uint8_t stMin)
+{
+    if (session >= kMaxSessions)
+        return;
+    _sessions[session].rxBlockSize = blockSize;
+    _sessions[session].rxStMin = stMin;
+}
+
+bool IsoTp::busy(uint8_t session) const
+{
+    if (session >= kMaxSessions)
+        return false;
+    State st = _sessions[session].state;
+    return st == State::TxWaitFc || st == State::TxSending || st == State::Rx;
+}
+
+bool IsoTp::send(uint8_t session, const uint8_t *data, uint16_t len)
+{
+    if (session >= kMaxSessions || _sessions[session].state != State::Idle || len > kBufferSize)
+        return false;
+    memcpy(_buffers[session], data, len);
+    return sendBuffer(session, len);
+}
+
+bool IsoTp::sendBuffer(uint8_t session, uint16_t len)
+{
+    if (session >= kMaxSessions || _sessions[session].state != State::Idle || !len || len > kBufferSize)
+        return false;
+    Session &s = _sessions[session];
+    const uint8_t *buf = _buffers[session];
+    s.len = len;
+
+    if (len <= 7)
+    {
+        uint8_t pci = (uint8_t)(PCI_SF | len);
+        return _sendRaw(s.txId, &pci, 1, buf, (uint8_t)len);
+    }
+
+    uint8_t pci[2] = {(uint8_t)(PCI_FF | (len >> 8)), (uint8_t)(len & 0xFF)};
+    if (!_sendRaw(s.txId, pci, 2, buf, 6))
+        return false;
+    s.offset = 6;
+    s.seq = 1;
+    s.state = State::TxWaitFc;
+    s.deadlineMs = millis() + kTimeoutMs;
+    return true;
+}
+
+void IsoTp::service()
+{
+    uint32_t nowMs = millis();
+    for (uint8_t i = 0; i < kMaxSessions; ++i)
+    {
+        Session &s = _sessions[i];
+        switch (s.state)
+        {
+        case State::TxSending:
+            if (!_sendConsecutive(i))
+                _finish(i, Result::TxFailed);
+            break;
+        case State::TxWaitFc:
+        case State::Rx:
+            if ((int32_t)(nowMs - s.deadlineMs) >= 0)
+                _finish(i, Result::Timeout);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+bool IsoTp::_sendConsecutive(uint8_t index)
+{
+    Session &s = _sessions[index];
+    for (uint8_t n = 0; n < kTxBurst && s.state == State::TxSending; ++n)
+    {
+        uint32_t now = micros();
+        if (s.stMinUs && now - s.lastUs < s.stMinUs)
+            return true;
+        if (n && s.stMinUs)
+            return true; // one frame per service() when paced
+
+        uint16_t remaining = (uint16_t)(s.len - s.offset);
+        uint8_t chunk = remaining > 7 ? 7 : (uint8_t)remaining;
+        uint8_t pci = (uint8_t)(PCI_CF | s.seq);
+        if (!_sendRaw(s.txId, &pci, 1, _buffers[index] + s.offset, chunk))
+            return false;
+        s.lastUs = now;
+        s.offset += chunk;
+        s.seq = (uint8_t)((s.seq + 1) & 0x0F);
+
+        if (s.offset >= s.len)
+        {
+            s.state = State::Idle; // sent; the reply arrives as a new message
+        }
+        else if (s.blockSize && --s.blockLeft == 0)
+        {
+            s.state = State::TxWaitFc;
+            s.deadlineMs = millis() + kTimeoutMs;
+        }
+    }
+    return true;
+}
+
+bool IsoTp::_onFrame(const CANManager::Frame &f, void *ctx)
+{
+    IsoTp *self = static_cast<IsoTp *>(ctx);
+    if (f.extended || f.rtr || f.len < 1)
+        return false;
+    for (uint8_t i = 0; i < kMaxSessions; ++i)
+    {
+        const Session &s = self->_sessions[i];
+        if (s.state != State::Closed && s.rxId == f.id)
+            return self->_handle(i, f);
+    }
+    return false;
+}
+
+bool IsoTp::_handle(uint8_t index, const CANManager::Frame &f)
+{
+    Session &s = _sessions[index];
+    uint8_t *buf = _buffers[index];
+    uint8_t type = f.data[0] & 0xF0;
+
+    if (type == PCI_FC)
+    {
+        if (s.state == State::TxWaitFc)
+            _onFlowControl(index, f);
+        return true;
+    }
+    // While sending, the buffer holds the outgoing message.
+    if (s.state == State::TxWaitFc || s.state == State::TxSending)
+        return true;
+
+    if (type == PCI_SF)
+    {
+        uint8_t len = f.data[0] & 0x0F;
+        if (!len || len > f.len - 1)
+            return true;
+        memcpy(buf, &f.data[1], len);
+        s.len = len;
+        s.state = State::Idle;
+        if (s.handler)
+            s.handler(index, Result::Ok, buf, len, s.ctx);
+    }
+    else if (type == PCI_FF)
+    {
+        if (f.len < 8)
+            return true;
+        uint16_t len = (uint16_t)(((f.data[0] & 0x0F) << 8) | f.data[1]);
+        // FF_DL 1..7 should have been a single frame (ISO 15765-2 ignores it);
+        // 0 escapes to a 32-bit length above 4095, always too big here.
+        if (len && len < 8)
+            return true;
+        if (!len || len > kBufferSize)
+        {
+            _sendFlowControl(s, FC_OVERFLOW);
+            _finish(index, Result::Overflow);
+            return true;
+        }
+        memcpy(buf, &f.data[2], 6);
+        s.len = len;
+        s.offset = 6;
+        s.seq = 1;
+        s.blockLeft = s.rxBlockSize;
+        s.state = State::Rx;
+        s.deadlineMs = millis() + kTimeoutMs;
+        if (!_sendFlowControl(s, FC_CTS))
+            _finish(index, Result::TxFailed);
+    }
+    else if (type == PCI_CF && s.state == State::Rx)
+    {
+        if ((f.data[0] & 0x0F) != s.seq)
+        {
+            _finish(index, Result::SequenceError);
+            return true;
+        }
+        uint16_t remaining = (uint16_t)(s.len - s.offset);
+        uint8_t chunk = remaining > 7 ? 7 : (uint8_t)remaining;
+        if (chunk > f.len - 1)
+            chunk = (uint8_t)(f.len - 1);
+        memcpy(buf + s.offset, &f.data[1], chunk);
+        s.offset += chunk;
+        s.seq = (uint8_t)((s.seq + 1) & 0x0F);
+        s.deadlineMs = millis() + kTimeoutMs;
+
+        if (s.offset >= s.len)
+        {
+            s.state = State::Idle;
+            if (s.handler)
+                s.handler(index, Result::Ok, buf, s.len, s.ctx);
+        }
+        else if (s.rxBlockSize && --s.blockLeft == 0)
+        {
+            s.blockLeft = s.rxBlockSize;
+            if (!_sendFlowControl(s, FC_CTS))
+                _finish(index, Result::TxFailed);
+        }
+    }
+    return true;
+}
+
+void IsoTp::_onFlowControl(uint8_t index, const CANManager::Frame &f)
+{
+    Session &s = _sessions[index];
+    uint8_t status = f.data[0] & 0x0F;
+    if (status == FC_WAIT)
+    {
+        s.deadlineMs = millis() + kTimeoutMs;
+        return;
+    }
+    if (status != FC_CTS || f.len < 3)
+    {
+        _finish(index, Result::Overflow);
+        return;
+    }
+    s.blockSize = f.data[1];
+    s.blockLeft = s.blockSize;
+    s.stMinUs = _stMinToUs(f.data[2]);
+    s.lastUs = micros() - s.stMinUs; // first CF may go immediately
+    s.state = State::TxSending;
+}
+
+bool IsoTp::_sendFlowControl(Session &s, uint8_t status)
+{
+    uint8_t pci[3] = {(uint8_t)(PCI_FC | status), s.rxBlockSize, s.rxStMin};
+    return _sendRaw(s.txId, pci, 3, nullptr, 0);
+}
+
+bool IsoTp::_sendRaw(uint16_t id, const uint8_t *pci, uint8_t pciLen, const uint8_t *data, uint8_t len)
+{
+    uint8_t frame[8];
+    memset(frame, kPadding, sizeof(frame));
+    memcpy(frame, pci, pciLen);
+    if (len)
+        memcpy(frame + pciLen, data, len);
+    return _can.sendFrame(id, frame, sizeof(frame));
+}
+
+void IsoTp::_finish(uint8_t index, Result result)
+{
+    Session &s = _sessions[index];
+    s.state = State::Idle;
+    if (s.handler)
+        s.handler(index, result, nullptr, 0, s.ctx);
+}
+
+uint32_t IsoTp::_stMinToUs(uint8_t stMin)
+{
+    if (stMin <= 0x7F)
+        return (uint32_t)stMin * 1000;
+    if (stMin >= 0xF1 && stMin <= 0xF9)
+        return (uint32_t)(stMin - 0xF0) * 100;
+    return 127000; // reserved values: use the longest defined gap
+}
+
+const __FlashStringHelper *IsoTp::resultName(Result r)
+{
+    switch (r)
+    {
+    case Result::Ok:
+        return F("ok");
+    case Result::Timeout:
+        return F("timeout");
+    case Result::Overflow:
+        return F("overflow");
+    case Result::SequenceError:
+        return F("sequence error");
+    case Result::TxFailed:
+        return F("tx failed");
+    }
+    return F("?");
+}
@@ -1,114 +1,158 @@
 #include "NeoKeyManager.h"
 #include "seesaw_neopixel.h"
 
-bool NeoKeyManager::begin(uint8_t address)
+bool NeoKeyManager::begin(const uint8_t *addresses, uint8_t count)
 {
-    if (!_neokey.begin(address))
+    _boardCount = 0;
+    for (uint8_t b = 0; b < count && b < kMaxBoards; ++b)
     {
-        return false;
+        if (!_boards[b].begin(addresses[b]))
+        {
+            return false;
+        }
+        _boardCount++;
     }
 
     // Slide on
-    for (uint16_t i = 0; i < _neokey.pixels.numPixels(); i++)
+    for (uint8_t i = 0; i < keyCount(); i++)
     {
-        _neokey.pixels.setPixelColor(i, seesaw_NeoPixel::Color(50, 0, 150));
-        _neokey.pixels.show();
+        Board &board = _boards[i / kKeysPerBoard];
+        board.pixels.setPixelColor(i % kKeysPerBoard, seesaw_NeoPixel::Color(50, 0, 150));
+        board.pixels.show();
         delay(75);
     }
 
     // Slide away
-    for (uint16_t i = 0; i < _neokey.pixels.numPixels(); i++)
+    for (uint8_t i = 0; i < keyCount(); i++)
     {
-        _neokey.pixels.setPixelColor(i, 0);
-        _neokey.pixels.show();
+        Board &board = _boards[i / kKeysPerBoard];
+        board.pixels.setPixelColor(i % kKeysPerBoard, 0);
+        board.pixels.show();
         delay(75);
     }
-    
+
+    return _boardCount > 0;
+}
+
+void NeoKeyManager::setDebounceTime(uint16_t debounceMs, uint16_t scanIntervalMs)
+{
+    // Held for debounceMs means seen on this many scans after the first.
+    uint16_t scans = scanIntervalMs ? (uint16_t)((debounceMs + scanIntervalMs - 1) / scanIntervalMs) : 0;
+    _debouncePreload = (uint8_t)(scans > 15 ? 15 : scans);
+
+    // Start every key mid-countdown, so one held at boot is debounced too.
+    for (uint8_t k = 0; k < 4; ++k)
+        _count[k] = (_debouncePreload & (1 << k)) ? 0xFFFFFFFF : 0;
+}
+
+bool NeoKeyManager::Board::collect(uint8_t &keys)
+{
+    uint8_t buf[4];
+    if (!_i2c_dev->read(buf, 4))
+        return false;
+    uint32_t gpio = ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+    keys = (uint8_t)(((~gpio) & NEOKEY_1X4_BUTTONMASK) >> NEOKEY_1X4_BUTTONA); // active low
     return true;
 }
 
 void NeoKeyManager::update()
 {
-    uint32_t now = millis();
-    uint8_t newButtons = _neokey.read();
-
-    for (uint8_t i = 0; i < 4; i++)
+    // Collect what every board latched since the last scan. A board that
+    // fails to answer, or whose pointer a pixel write moved, keeps its
+    // previous state for this scan.
+    for (uint8_t b = 0; b < _boardCount; ++b)
     {
-        uint8_t mask = (1 << i);
-        bool currentRawState = newButtons & mask;
-        bool debouncedState = _currentButtons & mask;
-
-        if (currentRawState != debouncedState)
+        uint8_t keys;
+        if ((_requested & (1 << b)) && _boards[b].collect(keys))
         {
-            // The button state has changed from its debounced state
-            if (_lastChangeTime[i] == 0)
-            {
-                // This is the first time we see a change, start the timer
-                _lastChangeTime[i] = now;
-            }
-            else if (now - _lastChangeTime[i] >= _debounceMs)
-            {
-                // The change has been stable for the debounce period.
-                // Update the official debounced state.
-                _currentButtons ^= mask; // Flip the bit
-                _changedMask |= mask;
-                if (currentRawState)
-                {
-                    _justPressedMask |= mask;
-                }
-                else
-                {
-                    _justReleasedMask |= mask;
-                }
-            }
-        }
-        else
-        {
-            // The state is stable, reset the timer
-            _lastChangeTime[i] = 0;
+            uint8_t shift = b * kKeysPerBoard;
+            _raw = (_raw & ~(0x0FUL << shift)) | ((uint32_t)keys << shift);
         }
     }
 
+    _debounce(_raw);
+
     if (_changedMask)
     { // Only touch pixels when a debounced state change occurs
-        for (uint8_t i = 0; i < 4; i++)
+        for (uint8_t b = 0; b < _boardCount; ++b)
         {
-            if (_changedMask & (1 << i))
+            uint8_t shift = b * kKeysPerBoard;
+            uint8_t changed = (uint8_t)((_changedMask >> shift) & 0x0F);
+            if (!changed)
+                continue;
+            for (uint8_t i = 0; i < kKeysPerBoard; i++)
             {
-                if (_currentButtons & (1 << i))
-                {
-                    _neokey.pixels.setPixelColor(i, _pressedColor);
-                }
-                else
+                if (changed & (1 << i))
                 {
-                    _neokey.pixels.setPixelColor(i, 0);
+                    bool pressed = _currentButtons & (1UL << (shift + i));
+                    _boards[b].pixels.setPixelColor(i, pressed ? _pressedColor : 0);
                 }
             }
+            _boards[b].pixels.show();
         }
-        _neokey.pixels.show();
-        _changedMask = 0; // Clear the mask after updating pixels
     }
+
+    // Queue the next read last, after this scan's pixel writes.
+    _requested = 0;
+    for (uint8_t b = 0; b < _boardCount; ++b)
+    {
+        if (_boards[b].request())
+            _requested |= (uint8_t)(1 << b);
+    }
+}
+
+void NeoKeyManager::_debounce(uint32_t raw)
+{
+    // All keys at once: those disagreeing with the debounced state count
+    // down, and toggle when a key is still disagreeing at zero.
+    uint32_t delta = raw ^ _currentButtons;
+    uint32_t expired = delta & ~(_count[0] | _count[1] | _count[2] | _count[3]);
+
+    uint32_t borrow = delta;
+    for (uint8_t k = 0; k < 4; ++k)
+    {
+        uint32_t c = _count[k];
+        _count[k] = c ^ borrow;
+        borrow &= ~c;
+    }
+
+    // Keys that agree again, or just toggled, restart the countdown.
+    uint32_t reload = ~delta | expired;
+    for (uint8_t k = 0; k < 4; ++k)
+    {
+        _count[k] &= ~reload;
+        if (_debouncePreload & (1 << k))
+            _count[k] |= reload;
+    }
+
+    _currentButtons ^= expired;
+    _changedMask = expired;
+    _justPressedMask |= expired & raw;
+    _justReleasedMask |= expired & ~raw;
 }
 
-uint8_t NeoKeyManager::justPressed()
+uint32_t NeoKeyManager::justPressed()
 {
-    uint8_t returnMask = _justPressedMask;
+    uint32_t returnMask = _justPressedMask;
     _justPressedMask = 0;
     return returnMask;
 }
 
-uint8_t NeoKeyManager::justReleased()
+uint32_t NeoKeyManager::justReleased()
 {
-    uint8_t returnMask = _justReleasedMask;
+    uint32_t returnMask = _justReleasedMask;
     _justReleasedMask = 0;
     return returnMask;
 }
 
 void NeoKeyManager::setKeyColor(uint8_t keyIndex, uint8_t r, uint8_t g, uint8_t b)
 {
-    if (keyIndex < 4)
+    if (keyIndex < keyCount())
     {
-        _neokey.pixels.setPixelColor(keyIndex, r, g, b);
-        _neokey.pixels.show();
+        uint8_t index = keyIndex / kKeysPerBoard;
+        Board &board = _boards[index];
+        board.pixels.setPixelColor(keyIndex % kKeysPerBoard, r, g, b);
+        board.pixels.show();
+        _requested &= (uint8_t)~(1 << index); // pointer now selects the pixel buffer
     }
-}
\ No newline at end of file
+}
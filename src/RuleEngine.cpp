@@ -0,0 +1,586 @@
+#include "RuleEngine.h"
+#include <LittleFS.h>
+
+static bool parseNumber(const char *s, long min, long max, int base, long &out)
+{
+    char *end;
+    long v = strtol(s, &end, base);
+    if (end == s || *end || v < min || v > max)
+        return false;
+    out = v;
+    return true;
+}
+
+void RuleEngine::clear()
+{
+    _codeLen = 0;
+    _ruleCount = 0;
+    memset(_rulesBySignal, 0, sizeof(_rulesBySignal));
+    for (Blink &b : _blinks)
+        b.active = false;
+}
+
+uint8_t RuleEngine::load(const char *text)
+{
+    clear();
+    char line[kMaxLine];
+    uint16_t lineNo = 0;
+    while (*text)
+    {
+        uint8_t len = 0;
+        while (*text && *text != '\n')
+        {
+            if (len < kMaxLine - 1)
+                line[len++] = *text;
+            text++;
+        }
+        if (*text)
+            text++;
+        line[len] = '\0';
+        _addLine(line, ++lineNo);
+    }
+    _evaluateAll();
+    return _ruleCount;
+}
+
+bool RuleEngine::loadFile(const char *path)
+{
+    File f = LittleFS.open(path, "r");
+    if (!f)
+        return false;
+    clear();
+    char line[kMaxLine];
+    uint16_t lineNo = 0;
+    while (f.available())
+    {
+        uint8_t len = 0;
+        int c;
+        while ((c = f.read()) >= 0 && c != '\n')
+        {
+            if (len < kMaxLine - 1)
+                line[len++] = (char)c;
+        }
+        line[len] = '\0';
+        _addLine(line, ++lineNo);
+    }
+    f.close();
+    _evaluateAll();
+    return true;
+}
+
+void RuleEngine::_addLine(char *line, uint16_t lineNo)
+{
+    char *p = line;
+    while (*p == ' ' || *p == '\t')
+        p++;
+    char *cr = strchr(p, '\r');
+    if (cr)
+        *cr = '\0';
+    if (!*p || *p == '#')
+        return;
+
+    uint16_t codeMark = _codeLen;
+    const char *error = nullptr;
+    if (_ruleCount >= kMaxRules)
+        error = "too many rules";
+    else if (_compileLine(p, &error))
+        return;
+    _codeLen = codeMark;
+    Serial.print(F("Rule line "));
+    Serial.print(lineNo);
+    Serial.print(F(": "));
+    Serial.println(error);
+}
+
+bool RuleEngine::_compileLine(char *line, const char **error)
+{
+    // Split on whitespace, with parentheses as tokens of their own.
+    char buf[kMaxLine * 2];
+    char *tok[kMaxTokens];
+    uint8_t count = 0;
+    uint16_t n = 0;
+    for (char *p = line; *p;)
+    {
+        if (*p == ' ' || *p == '\t')
+        {
+            p++;
+            continue;
+        }
+        if (count >= kMaxTokens)
+        {
+            *error = "too many tokens";
+            return false;
+        }
+        tok[count++] = &buf[n];
+        if (*p == '(' || *p == ')')
+            buf[n++] = *p++;
+        else
+            while (*p && *p != ' ' && *p != '\t' && *p != '(' && *p != ')')
+                buf[n++] = *p++;
+        buf[n++] = '\0';
+    }
+
+    if (count == 0 || strcmp(tok[0], "when") != 0)
+    {
+        *error = "expected 'when'";
+        return false;
+    }
+
+    Rule &r = _rules[_ruleCount];
+    r = Rule{};
+    r.codeStart = _codeLen;
+    r.last = -1;
+    uint8_t pos = 1;
+    uint8_t depth = 0;
+    if (!_compileExpr(tok, count, pos, depth, r.deps, error))
+        return false;
+    if (_codeLen - r.codeStart > 0xFF)
+    {
+        *error = "expression too long";
+        return false;
+    }
+    r.codeLen = (uint8_t)(_codeLen - r.codeStart);
+
+    if (pos >= count || strcmp(tok[pos], "then") != 0)
+    {
+        *error = "expected 'then'";
+        return false;
+    }
+    pos++;
+    if (!_compileAction(tok, count, pos, r.then, error))
+        return false;
+    if (pos < count && strcmp(tok[pos], "else") == 0)
+    {
+        pos++;
+        if (!_compileAction(tok, count, pos, r.otherwise, error))
+            return false;
+    }
+    if (pos != count)
+    {
+        *error = "unexpected text after action";
+        return false;
+    }
+
+    for (uint8_t i = 0; i < SIGNAL_COUNT; ++i)
+    {
+        if (r.deps & (1UL << i))
+            _rulesBySignal[i] |= 1UL << _ruleCount;
+    }
+    _ruleCount++;
+    return true;
+}
+
+bool RuleEngine::_compileExpr(char **tok, uint8_t count, uint8_t &pos, uint8_t &depth, uint32_t &deps, const char **error)
+{
+    if (!_compileAnd(tok, count, pos, depth, deps, error))
+        return false;
+    while (pos < count && strcmp(tok[pos], "or") == 0)
+    {
+        pos++;
+        if (!_compileAnd(tok, count, pos, depth, deps, error) || !_emit(OP_OR, error))
+            return false;
+        depth--;
+    }
+    return true;
+}
+
+bool RuleEngine::_compileAnd(char **tok, uint8_t count, uint8_t &pos, uint8_t &depth, uint32_t &deps, const char **error)
+{
+    if (!_compileUnary(tok, count, pos, depth, deps, error))
+        return false;
+    while (pos < count && strcmp(tok[pos], "and") == 0)
+    {
+        pos++;
+        if (!_compileUnary(tok, count, pos, depth, deps, error) || !_emit(OP_AND, error))
+            return false;
+        depth--;
+    }
+    return true;
+}
+
+bool RuleEngine::_compileUnary(char **tok, uint8_t count, uint8_t &pos, uint8_t &depth, uint32_t &deps, const char **error)
+{
+    if (pos >= count)
+    {
+        *error = "expression expected";
+        return false;
+    }
+    const char *t = tok[pos++];
+    if (strcmp(t, "not") == 0)
+        return _compileUnary(tok, count, pos, depth, deps, error) && _emit(OP_NOT, error);
+    if (strcmp(t, "(") == 0)
+    {
+        if (!_compileExpr(tok, count, pos, depth, deps, error))
+            return false;
+        if (pos >= count || strcmp(tok[pos], ")") != 0)
+        {
+            *error = "missing ')'";
+            return false;
+        }
+        pos++;
+        return true;
+    }
+
+    SignalId id = signalFromName(t);
+    if (id == SignalId::Count)
+    {
+        *error = "unknown signal";
+        return false;
+    }
+    if (++depth > kStackDepth)
+    {
+        *error = "expression too deep";
+        return false;
+    }
+    deps |= 1UL << (uint8_t)id;
+    if (!_emit(OP_SIG, error) || !_emit((uint8_t)id, error))
+        return false;
+
+    // Optional comparison against a constant
+    static const char *const cmpNames[] = {"==", "!=", "<", "<=", ">", ">="};
+    static const Op cmpOps[] = {OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE};
+    if (pos >= count)
+        return true;
+    for (uint8_t i = 0; i < 6; ++i)
+    {
+        if (strcmp(tok[pos], cmpNames[i]) != 0)
+            continue;
+        long v;
+        if (pos + 1 >= count || !parseNumber(tok[pos + 1], INT16_MIN, INT16_MAX, 0, v))
+        {
+            *error = "expected number after comparison";
+            return false;
+        }
+        pos += 2;
+        if (depth + 1 > kStackDepth)
+        {
+            *error = "expression too deep";
+            return false;
+        }
+        return _emit(OP_CONST, error) && _emit((uint8_t)(v & 0xFF), error) &&
+               _emit((uint8_t)((v >> 8) & 0xFF), error) && _emit(cmpOps[i], error);
+    }
+    return true;
+}
+
+bool RuleEngine::_compileAction(char **tok, uint8_t count, uint8_t &pos, Action &a, const char **error)
+{
+    if (pos >= count)
+    {
+        *error = "action expected";
+        return false;
+    }
+    const char *verb = tok[pos++];
+    if (strcmp(verb, "led") == 0 || strcmp(verb, "blink") == 0)
+    {
+        bool blink = verb[0] == 'b';
+        long v[5];
+        for (uint8_t i = 0; i < (blink ? 5 : 4); ++i)
+        {
+            long max = i == 0 ? 31 : i == 4 ? 60000 : 255;
+            if (pos >= count || !parseNumber(tok[pos++], i == 4 ? 20 : 0, max, 10, v[i]))
+            {
+                *error = blink ? "usage: blink <key> <r> <g> <b> <period_ms>" : "usage: led <key> <r> <g> <b>";
+                return false;
+            }
+        }
+        a.type = blink ? ActionType::Blink : ActionType::Led;
+        a.key = (uint8_t)v[0];
+        a.r = (uint8_t)v[1];
+        a.g = (uint8_t)v[2];
+        a.b = (uint8_t)v[3];
+        if (blink)
+            a.id = (uint16_t)v[4];
+        return true;
+    }
+    if (strcmp(verb, "tx") == 0)
+    {
+        long v;
+        if (pos >= count || !parseNumber(tok[pos++], 0, 0x7FF, 16, v))
+        {
+            *error = "usage: tx <id> [bytes...]";
+            return false;
+        }
+        a.type = ActionType::Tx;
+        a.id = (uint16_t)v;
+        while (pos < count && strcmp(tok[pos], "else") != 0)
+        {
+            if (a.len >= 8 || !parseNumber(tok[pos++], 0, 0xFF, 16, v))
+            {
+                *error = "tx payload must be up to 8 hex bytes";
+                return false;
+            }
+            a.data[a.len++] = (uint8_t)v;
+        }
+        return true;
+    }
+    if (strcmp(verb, "status") == 0)
+    {
+        static const char *const names[] = {"off", "waiting", "ok", "error"};
+        for (uint8_t i = 0; pos < count && i < 4; ++i)
+        {
+            if (strcmp(tok[pos], names[i]) == 0)
+            {
+                pos++;
+                a.type = ActionType::Status;
+                a.data[0] = i; // StatusLED::State order
+                return true;
+            }
+        }
+        *error = "usage: status off|waiting|ok|error";
+        return false;
+    }
+    *error = "unknown action";
+    return false;
+}
+
+bool RuleEngine::_emit(uint8_t byte, const char **error)
+{
+    if (_codeLen >= kCodeSize)
+    {
+        *error = "rule memory full";
+        return false;
+    }
+    _code[_codeLen++] = byte;
+    return true;
+}
+
+void RuleEngine::setSignal(SignalId id, int32_t value, bool stale)
+{
+    uint8_t i = (uint8_t)id;
+    if (i >= SIGNAL_COUNT)
+        return;
+    uint32_t bit = 1UL << i;
+    // A restored value confirmed live re-lights its LEDs at full brightness.
+    bool refresh = (_stale & bit) && !stale;
+    if (stale)
+        _stale |= bit;
+    else
+        _stale &= ~bit;
+    if ((_known & bit) && _values[i] == value && !refresh)
+        return;
+    _values[i] = value;
+    _known |= bit;
+    for (uint32_t m = _rulesBySignal[i]; m; m &= m - 1)
+        _evaluate((uint8_t)__builtin_ctzl(m), refresh);
+}
+
+void RuleEngine::dropSignal(SignalId id)
+{
+    uint8_t i = (uint8_t)id;
+    if (i >= SIGNAL_COUNT || !(_known & (1UL << i)))
+        return;
+    _known &= ~(1UL << i);
+    _stale &= ~(1UL << i);
+    for (uint32_t m = _rulesBySignal[i]; m; m &= m - 1)
+    {
+        Rule &r = _rules[__builtin_ctzl(m)];
+        if (r.last < 0)
+            continue;
+        const Action &a = r.last ? r.then : r.otherwise;
+        if (a.type == ActionType::Led || a.type == ActionType::Blink)
+        {
+            _cancelBlink(a.key);
+            _keys.setKeyColor(a.key, 0, 0, 0);
+        }
+        r.last = -1;
+    }
+}
+
+void RuleEngine::_evaluateAll()
+{
+    for (uint8_t i = 0; i < _ruleCount; ++i)
+        _evaluate(i);
+}
+
+void RuleEngine::_evaluate(uint8_t ruleIndex, bool refresh)
+{
+    Rule &r = _rules[ruleIndex];
+    if ((r.deps & _known) != r.deps)
+        return; // wait until every referenced signal has been seen
+    int8_t v = _run(r) ? 1 : 0;
+    bool dim = r.deps & _stale;
+    if (v == r.last)
+    {
+        // Same outcome; only an LED it drives may need its brightness back.
+        const Action &a = v ? r.then : r.otherwise;
+        if (refresh && (a.type == ActionType::Led || a.type == ActionType::Blink))
+            _execute(a, dim);
+        return;
+    }
+    r.last = v;
+    if (v)
+        _execute(r.then, dim);
+    else if (r.otherwise.type != ActionType::None)
+        _execute(r.otherwise, dim);
+    else if (r.then.type == ActionType::Blink)
+    {
+        // A blink without an else stops (and goes dark) with its condition.
+        _cancelBlink(r.then.key);
+        _keys.setKeyColor(r.then.key, 0, 0, 0);
+    }
+}
+
+int32_t RuleEngine::_run(const Rule &r) const
+{
+    // Stack depth was bounded when the rule was compiled.
+    int32_t st[kStackDepth];
+    uint8_t sp = 0;
+    const uint8_t *pc = &_code[r.codeStart];
+    const uint8_t *end = pc + r.codeLen;
+    while (pc < end)
+    {
+        uint8_t op = *pc++;
+        if (op == OP_SIG)
+        {
+            st[sp++] = _values[*pc++];
+            continue;
+        }
+        if (op == OP_CONST)
+        {
+            st[sp++] = (int16_t)(pc[0] | (pc[1] << 8));
+            pc += 2;
+            continue;
+        }
+        if (op == OP_NOT)
+        {
+            st[sp - 1] = !st[sp - 1];
+            continue;
+        }
+        int32_t b = st[--sp];
+        int32_t &a = st[sp - 1];
+        switch (op)
+        {
+        case OP_EQ:
+            a = a == b;
+            break;
+        case OP_NE:
+            a = a != b;
+            break;
+        case OP_LT:
+            a = a < b;
+            break;
+        case OP_LE:
+            a = a <= b;
+            break;
+        case OP_GT:
+            a = a > b;
+            break;
+        case OP_GE:
+            a = a >= b;
+            break;
+        case OP_AND:
+            a = a && b;
+            break;
+        case OP_OR:
+            a = a || b;
+            break;
+        }
+    }
+    return sp ? st[0] : 0;
+}
+
+void RuleEngine::_execute(const Action &a, bool dim)
+{
+    uint8_t shift = dim ? kStaleDimShift : 0;
+    switch (a.type)
+    {
+    case ActionType::None:
+        break;
+    case ActionType::Led:
+        _cancelBlink(a.key);
+        _keys.setKeyColor(a.key, a.r >> shift, a.g >> shift, a.b >> shift);
+        break;
+    case ActionType::Blink:
+        _startBlink(a, dim);
+        break;
+    case ActionType::Tx:
+        _can.sendFrame(a.id, a.data, a.len);
+        break;
+    case ActionType::Status:
+        _status.setState((StatusLED::State)a.data[0]);
+        break;
+    }
+}
+
+void RuleEngine::_startBlink(const Action &a, bool dim)
+{
+    uint8_t shift = dim ? kStaleDimShift : 0;
+    Blink *slot = nullptr;
+    for (Blink &b : _blinks)
+    {
+        if (b.active && b.key == a.key)
+        {
+            slot = &b;
+            break;
+        }
+        if (!b.active && !slot)
+            slot = &b;
+    }
+    if (!slot)
+        return;
+    *slot = Blink{true, a.key, (uint8_t)(a.r >> shift), (uint8_t)(a.g >> shift), (uint8_t)(a.b >> shift), a.id,
+                  (uint32_t)millis(), true};
+    _keys.setKeyColor(slot->key, slot->r, slot->g, slot->b);
+}
+
+void RuleEngine::_cancelBlink(uint8_t key)
+{
+    for (Blink &b : _blinks)
+    {
+        if (b.active && b.key == key)
+            b.active = false;
+    }
+}
+
+void RuleEngine::update(uint32_t nowMs)
+{
+    for (Blink &b : _blinks)
+    {
+        if (!b.active || nowMs - b.lastToggleMs < b.periodMs / 2)
+            continue;
+        b.lastToggleMs = nowMs;
+        b.lit = !b.lit;
+        if (b.lit)
+            _keys.setKeyColor(b.key, b.r, b.g, b.b);
+        else
+            _keys.setKeyColor(b.key, 0, 0, 0);
+    }
+}
+
+void RuleEngine::printRules(Print &out) const
+{
+    out.print(F("Rules: "));
+    out.print(_ruleCount);
+    out.print(F(" ("));
+    out.print(_codeLen);
+    out.println(F(" bytes of bytecode)"));
+    for (uint8_t i = 0; i < _ruleCount; ++i)
+    {
+        const Rule &r = _rules[i];
+        out.print(F("  #"));
+        out.print(i);
+        out.print(F(" state="));
+        out.print(r.last < 0 ? F("?") : r.last ? F("1") : F("0"));
+        out.print(F(" deps="));
+        bool first = true;
+        for (uint8_t s = 0; s < SIGNAL_COUNT; ++s)
+        {
+            if (!(r.deps & (1UL << s)))
+                continue;
+            if (!first)
+                out.print(',');
+            out.print(signalName((SignalId)s));
+            first = false;
+        }
+        out.print(F(" code="));
+        for (uint8_t j = 0; j < r.codeLen; ++j)
+        {
+            uint8_t b = _code[r.codeStart + j];
+            if (b < 0x10)
+                out.print('0');
+            out.print(b, HEX);
+        }
+        out.println();
+    }
+}
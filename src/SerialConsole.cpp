@@ -0,0 +1,86 @@
+#include "SerialConsole.h"
+
+bool SerialConsole::addCommand(const char *name, Handler handler, const char *help)
+{
+    if (_commandCount >= kMaxCommands || !name || !handler)
+        return false;
+    _commands[_commandCount++] = {name, help, handler};
+    return true;
+}
+
+void SerialConsole::update()
+{
+    while (Serial.available() > 0)
+    {
+        int c = Serial.read();
+        if (c < 0)
+            break;
+        if (c == '\r' || c == '\n')
+        {
+            if (_overflow)
+            {
+                Serial.println(F("Command too long"));
+            }
+            else if (_len)
+            {
+                _line[_len] = '\0';
+                _dispatch();
+            }
+            _len = 0;
+            _overflow = false;
+        }
+        else if (_len < kLineLen)
+        {
+            _line[_len++] = (char)c;
+        }
+        else
+        {
+            _overflow = true;
+        }
+    }
+}
+
+void SerialConsole::_dispatch()
+{
+    char *argv[kMaxArgs];
+    uint8_t argc = 0;
+    char *p = _line;
+    while (*p && argc < kMaxArgs)
+    {
+        while (*p == ' ')
+            *p++ = '\0';
+        if (!*p)
+            break;
+        argv[argc++] = p;
+        while (*p && *p != ' ')
+            p++;
+    }
+    if (!argc)
+        return;
+
+    if (strcmp(argv[0], "help") == 0)
+    {
+        _printHelp();
+        return;
+    }
+    for (uint8_t i = 0; i < _commandCount; ++i)
+    {
+        if (strcmp(argv[0], _commands[i].name) == 0)
+        {
+            _commands[i].handler(argc, argv);
+            return;
+        }
+    }
+    Serial.print(F("Unknown command: "));
+    Serial.println(argv[0]);
+}
+
+void SerialConsole::_printHelp()
+{
+    for (uint8_t i = 0; i < _commandCount; ++i)
+    {
+        Serial.print(_commands[i].name);
+        Serial.print(F(" - "));
+        Serial.println(_commands[i].help ? _commands[i].help : "");
+    }
+}
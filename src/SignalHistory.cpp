@@ -0,0 +1,131 @@
+#include "SignalHistory.h"
+
+void SignalHistory::record(SignalId id, uint32_t ms, int32_t value)
+{
+    if ((uint8_t)id >= SIGNAL_COUNT)
+        return;
+    SignalState &s = _sig[(uint8_t)id];
+    bool changed = !s.hasValue || value != s.last;
+
+    uint32_t index = ms / kBucketMs;
+    Bucket &b = s.buckets[index % kBuckets];
+    if (b.index != index || b.samples == 0)
+    {
+        // Slot still holds an older window; start it over.
+        b.index = index;
+        b.min = value;
+        b.max = value;
+        b.samples = 0;
+        b.changes = 0;
+    }
+    if (value < b.min)
+        b.min = value;
+    if (value > b.max)
+        b.max = value;
+    if (b.samples < 0xFFFF)
+        b.samples++;
+    if (changed && s.hasValue && b.changes < 0xFFFF)
+        b.changes++;
+
+    if (changed)
+    {
+        s.events[s.head] = {ms, value};
+        s.head = (uint8_t)((s.head + 1) % kEventsPerSignal);
+        if (s.count < kEventsPerSignal)
+            s.count++;
+    }
+    s.last = value;
+    s.hasValue = true;
+}
+
+bool SignalHistory::event(SignalId id, uint8_t ago, Event &out) const
+{
+    if ((uint8_t)id >= SIGNAL_COUNT)
+        return false;
+    const SignalState &s = _sig[(uint8_t)id];
+    if (ago >= s.count)
+        return false;
+    out = s.events[(s.head + kEventsPerSignal - 1 - ago) % kEventsPerSignal];
+    return true;
+}
+
+bool SignalHistory::bucket(SignalId id, uint8_t ago, uint32_t nowMs, Bucket &out) const
+{
+    if ((uint8_t)id >= SIGNAL_COUNT || ago >= kBuckets)
+        return false;
+    uint32_t current = nowMs / kBucketMs;
+    if (ago > current)
+        return false;
+    uint32_t index = current - ago;
+    const Bucket &b = _sig[(uint8_t)id].buckets[index % kBuckets];
+    if (b.index != index || b.samples == 0)
+        return false;
+    out = b;
+    return true;
+}
+
+void SignalHistory::printSummary(Print &out, uint32_t nowMs) const
+{
+    for (uint8_t i = 0; i < SIGNAL_COUNT; ++i)
+    {
+        SignalId id = (SignalId)i;
+        uint32_t changes = 0;
+        uint32_t samples = 0;
+        Bucket b;
+        for (uint8_t ago = 0; ago < kBuckets; ++ago)
+        {
+            if (bucket(id, ago, nowMs, b))
+            {
+                changes += b.changes;
+                samples += b.samples;
+            }
+        }
+        out.print(signalName(id));
+        out.print(F(": "));
+        if (hasValue(id))
+            out.print(lastValue(id));
+        else
+            out.print(F("-"));
+        out.print(F(" samples="));
+        out.print(samples);
+        out.print(F(" changes="));
+        out.print(changes);
+        out.print(F(" (last "));
+        out.print((uint32_t)kBuckets * kBucketMs / 1000);
+        out.println(F("s)"));
+    }
+}
+
+void SignalHistory::printSignal(Print &out, SignalId id, uint32_t nowMs) const
+{
+    out.print(signalName(id));
+    out.println(F(" events (age ms -> value):"));
+    Event e;
+    for (uint8_t ago = 0; event(id, ago, e); ++ago)
+    {
+        out.print(F("  -"));
+        out.print(nowMs - e.ms);
+        out.print(F(" -> "));
+        out.println(e.value);
+    }
+
+    out.print(F(" buckets of "));
+    out.print(kBucketMs);
+    out.println(F("ms (age ms: min/max samples changes):"));
+    Bucket b;
+    for (uint8_t ago = 0; ago < kBuckets; ++ago)
+    {
+        if (!bucket(id, ago, nowMs, b))
+            continue;
+        out.print(F("  -"));
+        out.print(nowMs - b.index * kBucketMs);
+        out.print(F(": "));
+        out.print(b.min);
+        out.print('/');
+        out.print(b.max);
+        out.print(' ');
+        out.print(b.samples);
+        out.print(' ');
+        out.println(b.changes);
+    }
+}
@@ -0,0 +1,229 @@
+#ifdef __linux__
+
+#include "SocketCanTransport.h"
+
+#include <linux/can/raw.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+SocketCanTransport::SocketCanTransport(const char *ifname)
+{
+    strncpy(_ifname, ifname, sizeof(_ifname) - 1);
+    _ifname[sizeof(_ifname) - 1] = '\0';
+}
+
+SocketCanTransport::~SocketCanTransport()
+{
+    if (_fd >= 0)
+        close(_fd);
+}
+
+bool SocketCanTransport::_open()
+{
+    _fd = socket(PF_CAN, SOCK_RAW | SOCK_NONBLOCK, CAN_RAW);
+    if (_fd < 0)
+        return false;
+
+    struct ifreq ifr = {};
+    memcpy(ifr.ifr_name, _ifname, sizeof(ifr.ifr_name));
+    struct sockaddr_can addr = {};
+    addr.can_family = AF_CAN;
+    int on = 1;
+    int rcvbuf = kRcvBufBytes;
+    bool ok = ioctl(_fd, SIOCGIFINDEX, &ifr) == 0;
+    if (ok)
+    {
+        addr.can_ifindex = ifr.ifr_ifindex;
+        ok = bind(_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0 &&
+             setsockopt(_fd, SOL_SOCKET, SO_TIMESTAMPNS, &on, sizeof(on)) == 0 &&
+             setsockopt(_fd, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on)) == 0;
+    }
+    if (!ok)
+    {
+        close(_fd);
+        _fd = -1;
+        return false;
+    }
+    // Best effort: capped by net.core.rmem_max.
+    setsockopt(_fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    return true;
+}
+
+bool SocketCanTransport::begin(uint32_t bitrate)
+{
+    (void)bitrate;
+    if (_fd < 0 && !_open())
+        return false;
+    _count = _next = 0;
+    return _setOwnMessages(false) && _applyFilters();
+}
+
+bool SocketCanTransport::loopback()
+{
+    return _fd >= 0 && _setOwnMessages(true);
+}
+
+bool SocketCanTransport::_setOwnMessages(bool enabled)
+{
+    int on = enabled;
+    return setsockopt(_fd, SOL_CAN_RAW, CAN_RAW_RECV_OWN_MSGS, &on, sizeof(on)) == 0;
+}
+
+bool SocketCanTransport::setFilter(uint8_t slot, uint16_t id)
+{
+    if (slot >= kFilterSlots)
+        return false;
+    _ids[slot] = id;
+    _used |= 1u << slot;
+    return _fd < 0 || _applyFilters();
+}
+
+bool SocketCanTransport::clearFilter(uint8_t slot)
+{
+    if (slot >= kFilterSlots)
+        return false;
+    _used &= ~(1u << slot);
+    return _fd < 0 || _applyFilters();
+}
+
+// Standard frames with exactly these IDs; an empty list receives nothing.
+bool SocketCanTransport::_applyFilters()
+{
+    struct can_filter filters[kFilterSlots];
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < kFilterSlots; ++i)
+    {
+        if (!(_used & (1u << i)))
+            continue;
+        filters[n].can_id = _ids[i];
+        filters[n].can_mask = CAN_EFF_FLAG | CAN_SFF_MASK;
+        n++;
+    }
+    return setsockopt(_fd, SOL_CAN_RAW, CAN_RAW_FILTER, n ? filters : nullptr, n * sizeof(filters[0])) == 0;
+}
+
+void SocketCanTransport::_fill()
+{
+    _count = _next = 0;
+    for (uint8_t i = 0; i < kBatch; ++i)
+    {
+        _iov[i].iov_base = &_frames[i];
+        _iov[i].iov_len = sizeof(_frames[i]);
+        _msgs[i].msg_hdr = {};
+        _msgs[i].msg_hdr.msg_iov = &_iov[i];
+        _msgs[i].msg_hdr.msg_iovlen = 1;
+        _msgs[i].msg_hdr.msg_control = _control[i];
+        _msgs[i].msg_hdr.msg_controllen = sizeof(_control[i]);
+    }
+    int n = recvmmsg(_fd, _msgs, kBatch, MSG_DONTWAIT, nullptr);
+    if (n <= 0)
+        return;
+
+    for (int i = 0; i < n; ++i)
+    {
+        _stampUs[i] = 0;
+        for (struct cmsghdr *c = CMSG_FIRSTHDR(&_msgs[i].msg_hdr); c; c = CMSG_NXTHDR(&_msgs[i].msg_hdr, c))
+        {
+            if (c->cmsg_level != SOL_SOCKET)
+                continue;
+            if (c->cmsg_type == SO_TIMESTAMPNS)
+            {
+                struct timespec ts;
+                memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+                _stampUs[i] = (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+            }
+            else if (c->cmsg_type == SO_RXQ_OVFL)
+            {
+                memcpy(&_stats.kernelDrops, CMSG_DATA(c), sizeof(_stats.kernelDrops));
+            }
+        }
+    }
+    _count = (uint8_t)n;
+    _stats.batches++;
+}
+
+bool SocketCanTransport::receive(CanFrame &f)
+{
+    if (_fd < 0)
+        return false;
+    if (_next == _count)
+    {
+        _fill();
+        if (!_count)
+            return false;
+    }
+
+    uint8_t i = _next++;
+    const struct can_frame &cf = _frames[i];
+    f = CanFrame{};
+    f.extended = cf.can_id & CAN_EFF_FLAG;
+    f.rtr = cf.can_id & CAN_RTR_FLAG;
+    f.id = cf.can_id & (f.extended ? CAN_EFF_MASK : CAN_SFF_MASK);
+    f.dlc = cf.can_dlc;
+    if (!f.rtr)
+    {
+        f.len = cf.can_dlc > 8 ? 8 : cf.can_dlc;
+        memcpy(f.data, cf.data, f.len);
+    }
+    f.timestampUs = _stampUs[i];
+
+    _stats.frames++;
+    if (f.timestampUs)
+    {
+        uint64_t now = _realtimeUs();
+        uint32_t latency = now > f.timestampUs ? (uint32_t)(now - f.timestampUs) : 0;
+        _stats.latencyTotalUs += latency;
+        if (latency > _stats.latencyMaxUs)
+            _stats.latencyMaxUs = latency;
+    }
+    return true;
+}
+
+bool SocketCanTransport::send(uint16_t id, const uint8_t *data, uint8_t len)
+{
+    struct can_frame cf = {};
+    cf.can_id = id & CAN_SFF_MASK;
+    cf.can_dlc = len > 8 ? 8 : len;
+    memcpy(cf.data, data, cf.can_dlc);
+    // Non-blocking: a full TX queue (ENOBUFS/EAGAIN) fails like a busy controller.
+    bool ok = _fd >= 0 && write(_fd, &cf, sizeof(cf)) == (ssize_t)sizeof(cf);
+    if (ok)
+        _stats.sent++;
+    else
+        _stats.sendFailed++;
+    return ok;
+}
+
+// Same clock as SO_TIMESTAMPNS.
+uint64_t SocketCanTransport::_realtimeUs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void SocketCanTransport::printStats(Print &out) const
+{
+    out.print(F("SocketCAN "));
+    out.print(_ifname);
+    out.print(F(": rx "));
+    out.print((uint32_t)_stats.frames);
+    out.print(F(" frames in "));
+    out.print((uint32_t)_stats.batches);
+    out.print(F(" batches ("));
+    out.print(_stats.batches ? (double)_stats.frames / _stats.batches : 0.0, 1);
+    out.print(F("/batch), kernel drops "));
+    out.println(_stats.kernelDrops);
+    out.print(F("  kernel-to-app latency avg="));
+    out.print(_stats.frames ? (uint32_t)(_stats.latencyTotalUs / _stats.frames) : 0);
+    out.print(F(" max="));
+    out.print(_stats.latencyMaxUs);
+    out.print(F(" us, tx "));
+    out.print((uint32_t)_stats.sent);
+    out.print(F(" ("));
+    out.print((uint32_t)_stats.sendFailed);
+    out.println(F(" failed)"));
+}
+
+#endif
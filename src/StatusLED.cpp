@@ -1,25 +1,155 @@
 #include "StatusLED.h"
+
+#if defined(ARDUINO_ARCH_RP2040)
+#include <hardware/clocks.h>
+#include <hardware/dma.h>
+#include <hardware/pio.h>
+
+// ws2812 program (pico-examples), 10 PIO cycles per bit with the data pin as
+// side-set: high for 2 cycles (T1) for a 0 bit, 7 (T1 + T2) for a 1 bit.
+//   bitloop: out x, 1        side 0 [2]
+//            jmp !x do_zero  side 1 [1]
+//            jmp bitloop     side 1 [4]
+//   do_zero: nop             side 0 [4]
+static const uint16_t kWs2812Program[] = {0x6221, 0x1123, 0x1400, 0xa442};
+static constexpr uint32_t kWs2812Hz = 800000;
+static constexpr uint8_t kWs2812CyclesPerBit = 10;
+static constexpr uint32_t kPixelUs = 24 * 1000000 / kWs2812Hz;
+static constexpr uint32_t kLatchUs = 300; // WS2812B-V5 needs > 280 us low
+
+static PIO g_pio = nullptr;
+static uint g_sm = 0;
+static int g_dma = -1;
+static uint32_t g_frame[StatusLED::kMaxPixels]; // DMA source: GRB in the top 24 bits
+static uint8_t g_frameLen = 0;
+static uint32_t g_frameStartUs = 0;
+
+static bool pxBegin(uint8_t pin, uint8_t, uint8_t)
+{
+    if (g_pio)
+        return g_dma >= 0;
+
+    pio_program_t program = {};
+    program.instructions = kWs2812Program;
+    program.length = 4;
+    program.origin = -1;
+
+    uint offset = 0;
+    const PIO pios[] = {pio0, pio1};
+    for (PIO p : pios)
+    {
+        if (!pio_can_add_program(p, &program))
+            continue;
+        int sm = pio_claim_unused_sm(p, false);
+        if (sm < 0)
+            continue;
+        g_pio = p;
+        g_sm = (uint)sm;
+        offset = pio_add_program(p, &program);
+        break;
+    }
+    if (!g_pio)
+        return false;
+    g_dma = dma_claim_unused_channel(false);
+    if (g_dma < 0)
+        return false;
+
+    pio_gpio_init(g_pio, pin);
+    pio_sm_set_consecutive_pindirs(g_pio, g_sm, pin, 1, true);
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset, offset + 3);
+    sm_config_set_sideset(&c, 1, false, false);
+    sm_config_set_sideset_pins(&c, pin);
+    sm_config_set_out_shift(&c, false, true, 24); // MSB first, autopull per pixel
+    sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+    sm_config_set_clkdiv(&c, (float)clock_get_hz(clk_sys) / (kWs2812Hz * kWs2812CyclesPerBit));
+    pio_sm_init(g_pio, g_sm, offset, &c);
+    pio_sm_set_enabled(g_pio, g_sm, true);
+
+    dma_channel_config d = dma_channel_get_default_config(g_dma);
+    channel_config_set_transfer_data_size(&d, DMA_SIZE_32);
+    channel_config_set_read_increment(&d, true);
+    channel_config_set_write_increment(&d, false);
+    channel_config_set_dreq(&d, pio_get_dreq(g_pio, g_sm, true));
+    dma_channel_configure(g_dma, &d, &g_pio->txf[g_sm], g_frame, 0, false);
+    return true;
+}
+
+// Starts the transfer and returns; false (nothing sent) while the previous
+// frame is still on the wire or inside its latch gap.
+static bool pxShow(const uint32_t *pixels, uint8_t n, uint8_t brightness)
+{
+    if (g_dma < 0)
+        return true;
+    if (dma_channel_is_busy(g_dma) || micros() - g_frameStartUs < g_frameLen * kPixelUs + kLatchUs)
+        return false;
+
+    uint16_t scale = (uint16_t)brightness + 1;
+    for (uint8_t i = 0; i < n; ++i)
+    {
+        uint32_t r = ((pixels[i] >> 16 & 0xFF) * scale) >> 8;
+        uint32_t g = ((pixels[i] >> 8 & 0xFF) * scale) >> 8;
+        uint32_t b = ((pixels[i] & 0xFF) * scale) >> 8;
+        g_frame[i] = (g << 24) | (r << 16) | (b << 8);
+    }
+    g_frameLen = n;
+    g_frameStartUs = micros();
+    dma_channel_transfer_from_buffer_now(g_dma, g_frame, n);
+    return true;
+}
+
+// Blocks until the frame in flight and its latch gap are over.
+static void pxWait()
+{
+    if (g_dma < 0)
+        return;
+    dma_channel_wait_for_finish_blocking(g_dma);
+    while (micros() - g_frameStartUs < g_frameLen * kPixelUs + kLatchUs)
+    {
+    }
+}
+
+#else
 #include <Adafruit_NeoPixel.h>
 
-static Adafruit_NeoPixel *g_px = nullptr;
+static Adafruit_NeoPixel g_px;
 
-StatusLED::StatusLED(uint8_t powerPin, uint8_t dataPin, uint8_t brightness)
-    : _powerPin(powerPin), _dataPin(dataPin), _brightness(brightness) {}
+static bool pxBegin(uint8_t pin, uint8_t n, uint8_t brightness)
+{
+    g_px.updateType(NEO_GRB + NEO_KHZ800);
+    g_px.updateLength(n);
+    g_px.setPin(pin);
+    g_px.begin();
+    g_px.setBrightness(brightness);
+    return true;
+}
+
+static bool pxShow(const uint32_t *pixels, uint8_t n, uint8_t)
+{
+    for (uint8_t i = 0; i < n; ++i)
+        g_px.setPixelColor(i, pixels[i]);
+    g_px.show();
+    return true;
+}
+
+static void pxWait() {}
+#endif
+
+StatusLED::StatusLED(uint8_t powerPin, uint8_t dataPin, uint8_t brightness, uint8_t numPixels)
+    : _powerPin(powerPin), _dataPin(dataPin), _brightness(brightness),
+      _numPixels(numPixels < 1 ? 1 : (numPixels > kMaxPixels ? kMaxPixels : numPixels)) {}
 
 bool StatusLED::begin()
 {
     pinMode(_powerPin, OUTPUT);
     digitalWrite(_powerPin, HIGH);
 
-    if (!g_px)
-    {
-        g_px = new Adafruit_NeoPixel(1, _dataPin, NEO_GRB + NEO_KHZ800);
-    }
-    g_px->begin();
-    g_px->setBrightness(_brightness);
-    g_px->show();
+    bool ok = pxBegin(_dataPin, _numPixels, _brightness);
+    for (uint8_t i = 0; i < _numPixels; ++i)
+        _pixels[i] = 0;
+    show();
     _state = State::Off;
-    return true;
+    return ok;
 }
 
 void StatusLED::setState(State s)
@@ -51,16 +181,57 @@ void StatusLED::setColor(uint8_t r, uint8_t g, uint8_t b)
     _showColor(r, g, b);
 }
 
-void StatusLED::_showColor(uint8_t r, uint8_t g, uint8_t b)
+void StatusLED::setPixel(uint8_t index, uint8_t r, uint8_t g, uint8_t b)
+{
+    if (index < _numPixels)
+        _pixels[index] = ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+}
+
+void StatusLED::show()
+{
+    _pending = !pxShow(_pixels, _numPixels, _brightness);
+    // A deferred frame is only retried by update(); if nobody is calling it,
+    // wait out the frame in flight (under a millisecond) and send now.
+    if (_pending && (!_polled || millis() - _lastUpdateMs > kUpdateGapMs))
+    {
+        pxWait();
+        _pending = !pxShow(_pixels, _numPixels, _brightness);
+    }
+}
+
+void StatusLED::showBar(uint16_t value, uint16_t max, uint8_t r, uint8_t g, uint8_t b)
 {
-    if (!g_px)
+    // Pixel 0 belongs to the state.
+    const uint8_t first = 1;
+    uint8_t len = _numPixels - first;
+    if (!len)
         return;
-    g_px->setPixelColor(0, g_px->Color(r, g, b));
-    g_px->show();
+    if (value > max)
+        value = max;
+    // Bar length in 1/255ths of a pixel
+    uint32_t level = max ? (uint32_t)value * len * 255 / max : 0;
+    for (uint8_t i = 0; i < len; ++i)
+    {
+        uint32_t part = level > 255 ? 255 : level;
+        level -= part;
+        setPixel(first + i, r * part / 255, g * part / 255, b * part / 255);
+    }
+    show();
+}
+
+void StatusLED::_showColor(uint8_t r, uint8_t g, uint8_t b)
+{
+    setPixel(0, r, g, b);
+    show();
 }
 
 void StatusLED::update()
 {
+    _polled = true;
+    _lastUpdateMs = millis();
+    if (_pending)
+        show();
+
     if (_state != State::Waiting)
         return;
     uint32_t now = millis();
@@ -0,0 +1,130 @@
+#include "UdsClient.h"
+
+static constexpr uint8_t SID_READ_DID = 0x22;
+static constexpr uint8_t SID_WRITE_DID = 0x2E;
+static constexpr uint8_t SID_NEGATIVE = 0x7F;
+static constexpr uint8_t POSITIVE_OFFSET = 0x40;
+static constexpr uint8_t NRC_RESPONSE_PENDING = 0x78;
+
+bool UdsClient::readDid(uint16_t txId, uint16_t rxId, uint16_t did, Callback cb, void *ctx)
+{
+    return _start(txId, rxId, SID_READ_DID, did, nullptr, 0, cb, ctx);
+}
+
+bool UdsClient::writeDid(uint16_t txId, uint16_t rxId, uint16_t did, const uint8_t *data, uint16_t len, Callback cb, void *ctx)
+{
+    return _start(txId, rxId, SID_WRITE_DID, did, data, len, cb, ctx);
+}
+
+bool UdsClient::_start(uint16_t txId, uint16_t rxId, uint8_t sid, uint16_t did, const uint8_t *data, uint16_t len, Callback cb, void *ctx)
+{
+    if (len > IsoTp::kBufferSize - 3)
+        return false;
+    int8_t session = _tp.open(txId, rxId, _onMessage, this);
+    if (session < 0)
+        return false;
+    _tp.setRxFlowControl((uint8_t)session, _blockSize, _stMin);
+
+    // Built in place in the session buffer.
+    uint8_t *req = _tp.buffer((uint8_t)session);
+    req[0] = sid;
+    req[1] = (uint8_t)(did >> 8);
+    req[2] = (uint8_t)(did & 0xFF);
+    if (len)
+        memcpy(req + 3, data, len);
+
+    Pending &p = _pending[session];
+    p = Pending{};
+    p.active = true;
+    p.sid = sid;
+    p.did = did;
+    p.cb = cb;
+    p.ctx = ctx;
+    p.startUs = micros();
+    p.deadlineMs = millis() + kP2Ms;
+    if (!_tp.sendBuffer((uint8_t)session, (uint16_t)(3 + len)))
+    {
+        p.active = false;
+        _tp.close((uint8_t)session);
+        return false;
+    }
+    return true;
+}
+
+void UdsClient::service()
+{
+    uint32_t nowMs = millis();
+    for (uint8_t i = 0; i < IsoTp::kMaxSessions; ++i)
+    {
+        // A transfer still in progress is timed by the transport itself.
+        if (!_pending[i].active || _tp.busy(i) || (int32_t)(nowMs - _pending[i].deadlineMs) < 0)
+            continue;
+        Response r;
+        r.status = Status::Timeout;
+        _complete(i, r);
+    }
+}
+
+void UdsClient::_onMessage(uint8_t session, IsoTp::Result result, const uint8_t *data, uint16_t len, void *ctx)
+{
+    UdsClient *self = static_cast<UdsClient *>(ctx);
+    Pending &p = self->_pending[session];
+    if (!p.active)
+        return;
+
+    Response r;
+    if (result != IsoTp::Result::Ok)
+    {
+        r.status = Status::Transport;
+        r.transport = result;
+    }
+    else if (len >= 3 && data[0] == SID_NEGATIVE && data[1] == p.sid)
+    {
+        if (data[2] == NRC_RESPONSE_PENDING)
+        {
+            p.deadlineMs = millis() + kP2StarMs;
+            return;
+        }
+        r.status = Status::Negative;
+        r.nrc = data[2];
+    }
+    else if (len >= 3 && data[0] == p.sid + POSITIVE_OFFSET && ((data[1] << 8) | data[2]) == p.did)
+    {
+        r.data = data + 3;
+        r.len = (uint16_t)(len - 3);
+    }
+    else
+    {
+        r.status = Status::Invalid;
+    }
+    self->_complete(session, r);
+}
+
+void UdsClient::_complete(uint8_t session, Response &r)
+{
+    Pending &p = _pending[session];
+    p.active = false;
+    r.did = p.did;
+    r.elapsedUs = micros() - p.startUs;
+    if (p.cb)
+        p.cb(r, p.ctx);
+    _tp.close(session);
+}
+
+const __FlashStringHelper *UdsClient::statusName(Status s)
+{
+    switch (s)
+    {
+    case Status::Positive:
+        return F("positive");
+    case Status::Negative:
+        return F("negative");
+    case Status::Timeout:
+        return F("timeout");
+    case Status::Transport:
+        return F("transport error");
+    case Status::Invalid:
+        return F("invalid response");
+    }
+    return F("?");
+}
@@ -0,0 +1,232 @@
+#include "WarmStart.h"
+#include <LittleFS.h>
+
+bool WarmStart::restore(uint32_t signalMask)
+{
+    uint32_t start = micros();
+    _restoreMask = signalMask;
+    _restoredSlot = -1;
+    _current = Snapshot{};
+    for (uint8_t slot = 0; slot < 2; ++slot)
+    {
+        Header h;
+        Snapshot s;
+        if (!_read(slot, h, s))
+            continue;
+        // Sequence numbers wrap; the newer of the two wins.
+        if (_restoredSlot < 0 || (int32_t)(h.seq - _seq) > 0)
+        {
+            _restoredSlot = (int8_t)slot;
+            _seq = h.seq;
+            _current = s;
+        }
+    }
+
+    if (_restoredSlot >= 0)
+    {
+        _nextSlot = (uint8_t)(_restoredSlot ^ 1);
+        _current.signalMask &= signalMask;
+        for (uint8_t i = 0; i < SIGNAL_COUNT; ++i)
+        {
+            if (!(_current.signalMask & (1UL << i)))
+                _current.values[i] = 0;
+        }
+        if (_current.filterCount > kMaxFilterIds)
+            _current.filterCount = kMaxFilterIds;
+    }
+    _staleMask = _current.signalMask;
+    _expiredMask = 0;
+    _restoreMs = millis();
+    _written = _current;
+    _dirty = false;
+    _loadUs = micros() - start;
+    return _restoredSlot >= 0;
+}
+
+void WarmStart::setSignal(SignalId id, int32_t value)
+{
+    uint32_t bit = 1UL << (uint8_t)id;
+    _staleMask &= ~bit;
+    _expiredMask &= ~bit;
+    if (!(_restoreMask & bit))
+        return;
+    if ((_current.signalMask & bit) && _current.values[(uint8_t)id] == value)
+        return;
+    _current.signalMask |= bit;
+    _current.values[(uint8_t)id] = value;
+    _changed();
+}
+
+uint32_t WarmStart::expire(uint32_t nowMs)
+{
+    if (!_staleMask || nowMs - _restoreMs < WARM_START_STALE_MS)
+        return 0;
+    uint32_t expired = _staleMask;
+    _expiredMask |= expired;
+    _staleMask = 0;
+    return expired;
+}
+
+void WarmStart::setBitrate(uint32_t bitrate)
+{
+    if (_current.bitrate == bitrate)
+        return;
+    _current.bitrate = bitrate;
+    _changed();
+}
+
+void WarmStart::setRulesDefault(bool useDefault)
+{
+    if (_current.rulesDefault == (uint8_t)useDefault)
+        return;
+    _current.rulesDefault = useDefault;
+    _changed();
+}
+
+void WarmStart::setReplayFilter(uint8_t mode, const uint16_t *ids, uint8_t count)
+{
+    if (count > kMaxFilterIds)
+        count = kMaxFilterIds;
+    Snapshot s = _current;
+    s.filterMode = mode;
+    s.filterCount = count;
+    for (uint8_t i = 0; i < kMaxFilterIds; ++i)
+        s.filterIds[i] = i < count ? ids[i] : 0;
+    if (memcmp(&s, &_current, sizeof(s)) == 0)
+        return;
+    _current = s;
+    _changed();
+}
+
+void WarmStart::_changed()
+{
+    _changedMs = millis();
+    _dirty = memcmp(&_current, &_written, sizeof(_current)) != 0;
+}
+
+void WarmStart::service(uint32_t nowMs)
+{
+    if (!_dirty || nowMs - _changedMs < WARM_START_SETTLE_MS)
+        return;
+    if (_writes && nowMs - _lastWriteMs < WARM_START_MIN_INTERVAL_MS)
+        return;
+    save();
+}
+
+bool WarmStart::save()
+{
+    uint32_t start = micros();
+    _lastWriteMs = millis();
+    Header h;
+    h.magic = kMagic;
+    h.version = kVersion;
+    h.size = sizeof(Snapshot);
+    h.seq = _seq + 1;
+    h.crc = _crc(h.seq, _current);
+
+    // Overwrite the older file only; the newer one stays valid until this
+    // write has completed.
+    File f = LittleFS.open(WARM_START_PATHS[_nextSlot], "w");
+    if (!f)
+        return false;
+    bool ok = f.write((const uint8_t *)&h, sizeof(h)) == sizeof(h) &&
+              f.write((const uint8_t *)&_current, sizeof(_current)) == sizeof(_current);
+    f.close();
+    _writeUs = micros() - start;
+    _writes++;
+    if (!ok)
+        return false;
+
+    _seq = h.seq;
+    _written = _current;
+    _dirty = false;
+    _nextSlot ^= 1;
+    return true;
+}
+
+bool WarmStart::_read(uint8_t slot, Header &h, Snapshot &s)
+{
+    File f = LittleFS.open(WARM_START_PATHS[slot], "r");
+    if (!f || f.size() != sizeof(Header) + sizeof(Snapshot))
+        return false;
+    bool ok = f.read((uint8_t *)&h, sizeof(h)) == sizeof(h) &&
+              f.read((uint8_t *)&s, sizeof(s)) == sizeof(s);
+    f.close();
+    return ok && h.magic == kMagic && h.version == kVersion && h.size == sizeof(Snapshot) &&
+           h.crc == _crc(h.seq, s);
+}
+
+// CRC-32 (IEEE, reflected); bitwise, since it runs once per boot and write.
+uint32_t WarmStart::_crc(uint32_t seq, const Snapshot &s)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    auto feed = [&crc](const uint8_t *p, size_t n)
+    {
+        while (n--)
+        {
+            crc ^= *p++;
+            for (uint8_t k = 0; k < 8; ++k)
+                crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    };
+    feed((const uint8_t *)&seq, sizeof(seq));
+    feed((const uint8_t *)&s, sizeof(s));
+    return ~crc;
+}
+
+void WarmStart::printStatus(Print &out) const
+{
+    if (_restoredSlot >= 0)
+    {
+        out.print(F("Restored slot "));
+        out.print((char)('A' + _restoredSlot));
+        out.print(F(" in "));
+        out.print(_loadUs);
+        out.println(F(" us"));
+    }
+    else
+    {
+        out.println(F("No snapshot restored"));
+    }
+
+    out.print(F("Stale:"));
+    if (!_staleMask)
+        out.print(F(" none"));
+    for (uint8_t i = 0; i < SIGNAL_COUNT; ++i)
+    {
+        if (_staleMask & (1UL << i))
+        {
+            out.print(' ');
+            out.print(signalName((SignalId)i));
+        }
+    }
+    out.println();
+    if (_expiredMask)
+    {
+        out.print(F("Expired (no live sample):"));
+        for (uint8_t i = 0; i < SIGNAL_COUNT; ++i)
+        {
+            if (_expiredMask & (1UL << i))
+            {
+                out.print(' ');
+                out.print(signalName((SignalId)i));
+            }
+        }
+        out.println();
+    }
+
+    out.print(F("Seq "));
+    out.print(_seq);
+    out.print(F(", "));
+    out.print(_writes);
+    out.print(F(" writes this boot"));
+    if (_writes)
+    {
+        out.print(F(", last "));
+        out.print((millis() - _lastWriteMs) / 1000);
+        out.print(F(" s ago ("));
+        out.print(_writeUs);
+        out.print(F(" us)"));
+    }
+    out.println(_dirty ? F(", change pending") : F(""));
+}
@@ -1,14 +1,378 @@
 #include <Arduino.h>
+#include <LittleFS.h>
 #include "HardwareConfig.h"
 #include "NeoKeyManager.h"
 #include "EncoderManager.h"
 #include "StatusLED.h"
 #include "CANManager.h"
+#include "SignalHistory.h"
+#include "SerialConsole.h"
+#include "CanBenchmark.h"
+#include "CanReplay.h"
+#include "RuleEngine.h"
+#include "IsoTp.h"
+#include "UdsClient.h"
+#include "WarmStart.h"
 
 NeoKeyManager g_keypad;
 EncoderManager g_encoder(ENCODER_SWITCH_PIN, ENCODER_PIXEL_PIN);
-StatusLED g_statusLed;
+StatusLED g_statusLed(STATUS_LED_POWER_PIN, STATUS_LED_DATA_PIN, STATUS_LED_BRIGHTNESS, STATUS_LED_PIXELS);
 CANManager g_can;
+SignalHistory g_history;
+SerialConsole g_console;
+CanReplay g_replay(g_can);
+RuleEngine g_rules(g_keypad, g_can, g_statusLed);
+IsoTp g_isotp(g_can);
+UdsClient g_uds(g_isotp);
+WarmStart g_warm;
+
+// Used when RULES_PATH does not exist: indicator requests light keys 2/3,
+// brighter for ActiveHigh than ActiveLow, dark when off or unknown.
+static const char kDefaultRules[] =
+    "when indicatorLeft == 2 then led 2 255 120 0\n"
+    "when indicatorLeft == 1 then led 2 128 60 0\n"
+    "when indicatorLeft == 0 or indicatorLeft == 3 then led 2 0 0 0\n"
+    "when indicatorRight == 2 then led 3 255 120 0\n"
+    "when indicatorRight == 1 then led 3 128 60 0\n"
+    "when indicatorRight == 0 or indicatorRight == 3 then led 3 0 0 0\n";
+
+// Every decoded change goes through here: the rule engine acts on it and
+// the warm-start snapshot takes the live value (clearing its stale mark).
+static void publishSignal(SignalId id, int32_t value)
+{
+    g_rules.setSignal(id, value);
+    g_warm.setSignal(id, value);
+}
+
+// History takes every received frame, including repeats that skip decoding,
+// so its sample counts and window aggregates cover steady signals too.
+static void recordSample(uint32_t id, void *)
+{
+    if (id == CANManager::FrontLightingFrame::kId)
+    {
+        auto fl = g_can.getFrontLighting(false);
+        g_history.record(SignalId::IndicatorLeft, fl.lastRxMs, (int32_t)fl.indicatorLeftRequest);
+        g_history.record(SignalId::IndicatorRight, fl.lastRxMs, (int32_t)fl.indicatorRightRequest);
+    }
+    else if (id == CANManager::RightDoorStatusFrame::kId)
+    {
+        auto door = g_can.getRightDoorStatus(false);
+        g_history.record(SignalId::RearIntSwitch, door.lastRxMs, door.rearIntSwitchPressed);
+    }
+    else if (id == CANManager::SCCMLeftStalkFrame::kId)
+    {
+        auto stalk = g_can.getSCCMLeftStalk(false);
+        g_history.record(SignalId::HighBeamStalk, stalk.lastRxMs, (int32_t)stalk.highBeamStalkStatus);
+        g_history.record(SignalId::TurnStalk, stalk.lastRxMs, (int32_t)stalk.turnIndicatorStalkStatus);
+        g_history.record(SignalId::WashWipe, stalk.lastRxMs, (int32_t)stalk.washWipeButtonStatus);
+    }
+}
+
+static void loadRules()
+{
+    if (g_warm.snapshot().rulesDefault)
+    {
+        g_rules.load(kDefaultRules);
+        Serial.println(F("Using default rules (rules default)"));
+    }
+    else if (g_rules.loadFile(RULES_PATH))
+    {
+        Serial.print(F("Rules loaded from "));
+        Serial.println(RULES_PATH);
+    }
+    else
+    {
+        g_rules.load(kDefaultRules);
+        Serial.println(F("Using default rules"));
+    }
+    Serial.print(g_rules.ruleCount());
+    Serial.print(F(" rules, "));
+    Serial.print(g_rules.codeBytes());
+    Serial.println(F(" bytes"));
+}
+
+// stats           - per-ID frame counts and unchanged-payload skip rate,
+//                   plus the transport's own counters if it keeps any
+// stats reset
+static void cmdStats(uint8_t argc, char **argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "reset") == 0)
+        g_can.resetRxStats();
+    g_can.printRxStats(Serial);
+    g_can.transport().printStats(Serial);
+}
+
+static void printDidResponse(const UdsClient::Response &r, void *ctx)
+{
+    (void)ctx;
+    Serial.print(F("DID "));
+    for (uint16_t nibble = 0x1000; nibble > 1 && r.did < nibble; nibble >>= 4)
+        Serial.print('0');
+    Serial.print(r.did, HEX);
+    Serial.print(F(": "));
+    Serial.print(UdsClient::statusName(r.status));
+    if (r.status == UdsClient::Status::Negative)
+    {
+        Serial.print(F(" nrc=0x"));
+        Serial.print(r.nrc, HEX);
+    }
+    else if (r.status == UdsClient::Status::Transport)
+    {
+        Serial.print(F(" ("));
+        Serial.print(IsoTp::resultName(r.transport));
+        Serial.print(')');
+    }
+    Serial.print(F(", "));
+    Serial.print(r.len);
+    Serial.print(F(" bytes in "));
+    Serial.print(r.elapsedUs / 1000.0, 1);
+    Serial.print(F(" ms"));
+    if (r.len && r.elapsedUs)
+    {
+        Serial.print(F(" ("));
+        Serial.print((uint32_t)((uint64_t)r.len * 1000000 / r.elapsedUs));
+        Serial.print(F(" B/s)"));
+    }
+    Serial.println();
+    for (uint16_t i = 0; i < r.len && i < 32; ++i)
+    {
+        if (r.data[i] < 0x10)
+            Serial.print('0');
+        Serial.print(r.data[i], HEX);
+        Serial.print(' ');
+    }
+    if (r.len > 32)
+        Serial.print(F("..."));
+    if (r.len)
+        Serial.println();
+}
+
+// did <req_id> <did>              - ReadDataByIdentifier (hex), reply on req_id + 8
+// did <req_id> <did> <bytes...>   - WriteDataByIdentifier
+// did fc <block_size> <stmin_ms>  - flow control for replies
+static void cmdDid(uint8_t argc, char **argv)
+{
+    if (argc >= 4 && strcmp(argv[1], "fc") == 0)
+    {
+        g_uds.setFlowControl((uint8_t)strtoul(argv[2], nullptr, 10), (uint8_t)strtoul(argv[3], nullptr, 10));
+        return;
+    }
+    if (argc < 3)
+    {
+        Serial.println(F("Usage: did <req_id> <did> [bytes...] | fc <bs> <stmin>"));
+        return;
+    }
+    uint16_t txId = (uint16_t)strtoul(argv[1], nullptr, 16);
+    uint16_t rxId = (uint16_t)(txId + UDS_RESPONSE_ID_OFFSET);
+    uint16_t did = (uint16_t)strtoul(argv[2], nullptr, 16);
+    uint8_t data[SerialConsole::kMaxArgs];
+    uint8_t len = 0;
+    for (uint8_t i = 3; i < argc; ++i)
+        data[len++] = (uint8_t)strtoul(argv[i], nullptr, 16);
+    bool ok = len ? g_uds.writeDid(txId, rxId, did, data, len, printDidResponse, nullptr)
+                  : g_uds.readDid(txId, rxId, did, printDidResponse, nullptr);
+    if (!ok)
+        Serial.println(F("No free diagnostic session"));
+}
+
+// rules           - list compiled rules
+// rules reload    - recompile from RULES_PATH (or the defaults)
+// rules default   - use the built-in defaults (kept across resets until reload)
+static void cmdRules(uint8_t argc, char **argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "reload") == 0)
+    {
+        g_warm.setRulesDefault(false);
+        loadRules();
+    }
+    else if (argc >= 2 && strcmp(argv[1], "default") == 0)
+    {
+        g_warm.setRulesDefault(true);
+        g_rules.load(kDefaultRules);
+    }
+    g_rules.printRules(Serial);
+}
+
+#ifdef CAN_PROFILE
+// prof            - per-ID min/avg/max cost of each CAN path stage
+// prof reset
+static void cmdProf(uint8_t argc, char **argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "reset") == 0)
+        CanProfile::reset();
+    else
+        CanProfile::print(Serial);
+}
+#endif
+
+// Restored signal values go to the rules only, as stale (dimmed LEDs):
+// history keeps live samples.
+static void applyWarmStart()
+{
+    const WarmStart::Snapshot &s = g_warm.snapshot();
+    g_replay.setIdFilter((CanReplay::FilterMode)s.filterMode, s.filterIds, s.filterCount);
+    for (uint8_t i = 0; i < SIGNAL_COUNT; ++i)
+    {
+        if (s.signalMask & (1UL << i))
+            g_rules.setSignal((SignalId)i, s.values[i], true);
+    }
+}
+
+// warm            - snapshot status and stale signals
+// warm save       - write the snapshot now
+static void cmdWarm(uint8_t argc, char **argv)
+{
+    if (argc >= 2 && strcmp(argv[1], "save") == 0)
+        Serial.println(g_warm.save() ? F("Snapshot saved") : F("Snapshot write failed"));
+    g_warm.printStatus(Serial);
+}
+
+// hist            - current value and recent sample/change counts per signal
+// hist <signal>   - change events and per-bucket min/max for one signal
+static void cmdHist(uint8_t argc, char **argv)
+{
+    uint32_t now = millis();
+    if (argc < 2)
+    {
+        g_history.printSummary(Serial, now);
+        return;
+    }
+    SignalId id = signalFromName(argv[1]);
+    if (id == SignalId::Count)
+    {
+        Serial.print(F("Unknown signal: "));
+        Serial.println(argv[1]);
+        return;
+    }
+    g_history.printSignal(Serial, id, now);
+}
+
+// Listen-only bitrate search; reports the outcome and how long it took.
+static bool autoBaud(uint32_t preferred = 0)
+{
+    CANManager::AutoBaudResult ab;
+    bool ok = g_can.beginAutoBaud(&ab, preferred);
+    if (ok)
+    {
+        Serial.print(F("CAN bitrate detected: "));
+        Serial.print(ab.bitrate);
+    }
+    else
+    {
+        Serial.print(F("CAN auto-baud found no traffic"));
+    }
+    Serial.print(F(" ("));
+    Serial.print(ab.attempts);
+    Serial.print(F(" rates, "));
+    if (ab.rejected)
+    {
+        Serial.print(ab.rejected);
+        Serial.print(F(" with errors, "));
+    }
+    Serial.print(ab.elapsedMs);
+    Serial.println(F(" ms)"));
+    return ok;
+}
+
+// baud           - current bitrate
+// baud auto      - re-run the listen-only search
+// baud <bps>     - force a bitrate
+static void cmdBaud(uint8_t argc, char **argv)
+{
+    if (argc >= 2)
+    {
+        bool ok;
+        if (strcmp(argv[1], "auto") == 0)
+            ok = autoBaud();
+        else
+            ok = g_can.begin(strtoul(argv[1], nullptr, 10));
+        if (ok)
+        {
+            g_warm.setBitrate(g_can.bitrate());
+        }
+        else
+        {
+            Serial.println(F("Bitrate change failed, restoring default"));
+            g_can.begin(CAN_BAUDRATE);
+        }
+    }
+    Serial.print(F("CAN bitrate: "));
+    Serial.println(g_can.bitrate());
+}
+
+static void runBenchmark(uint16_t frames)
+{
+    Serial.println(F("Running CAN loopback benchmark..."));
+    CanBenchmark::Result r;
+    if (!CanBenchmark::run(g_can, frames, r))
+        Serial.println(F("WARNING: loopback mode or CAN re-init failed"));
+    CanBenchmark::print(Serial, r);
+}
+
+// bench [frames]  - loopback self-test and throughput benchmark
+static void cmdBench(uint8_t argc, char **argv)
+{
+    uint16_t frames = argc >= 2 ? (uint16_t)strtoul(argv[1], nullptr, 10) : CAN_BENCH_FRAMES;
+    runBenchmark(frames ? frames : CAN_BENCH_FRAMES);
+}
+
+// replay <file> [speed%] [loop]      - play a trace from LittleFS
+// replay stop | stats
+// replay include|exclude <id...>     - hex IDs; "replay all" clears the filter
+// replay convert <in.log> <out.ocr>  - candump log to compact format
+static void cmdReplay(uint8_t argc, char **argv)
+{
+    if (argc < 2)
+    {
+        Serial.println(F("Usage: replay <file> [speed%] [loop] | stop | stats | include|exclude <id...> | all | convert <in> <out>"));
+        return;
+    }
+    const char *sub = argv[1];
+    if (strcmp(sub, "stop") == 0)
+    {
+        g_replay.stop();
+        g_replay.printStats(Serial);
+    }
+    else if (strcmp(sub, "stats") == 0)
+    {
+        g_replay.printStats(Serial);
+    }
+    else if (strcmp(sub, "include") == 0 || strcmp(sub, "exclude") == 0 || strcmp(sub, "all") == 0)
+    {
+        uint16_t ids[CanReplay::kMaxIdFilters];
+        uint8_t n = 0;
+        for (uint8_t i = 2; i < argc && n < CanReplay::kMaxIdFilters; ++i)
+            ids[n++] = (uint16_t)strtoul(argv[i], nullptr, 16);
+        CanReplay::FilterMode mode = sub[0] == 'i'   ? CanReplay::FilterMode::Include
+                                     : sub[0] == 'e' ? CanReplay::FilterMode::Exclude
+                                                     : CanReplay::FilterMode::None;
+        g_replay.setIdFilter(mode, ids, n);
+        g_warm.setReplayFilter((uint8_t)mode, ids, n);
+    }
+    else if (strcmp(sub, "convert") == 0 && argc >= 4)
+    {
+        uint32_t frames = 0;
+        if (CanReplay::convertCandump(argv[2], argv[3], &frames))
+        {
+            Serial.print(F("Converted "));
+            Serial.print(frames);
+            Serial.println(F(" frames"));
+        }
+        else
+        {
+            Serial.println(F("Conversion failed"));
+        }
+    }
+    else
+    {
+        uint16_t speed = argc >= 3 ? (uint16_t)strtoul(argv[2], nullptr, 10) : 100;
+        bool loop = argc >= 4 && strcmp(argv[3], "loop") == 0;
+        if (g_replay.start(sub, speed, loop))
+            Serial.println(F("Replay started"));
+        else
+            Serial.println(F("Cannot open trace"));
+    }
+}
 
 void setup()
 {
@@ -24,7 +388,7 @@ void setup()
     Serial.println();
     Serial.println(F("OpenCANDeck input system starting..."));
 
-    if (!g_keypad.begin(NEOKEY_I2C_ADDR))
+    if (!g_keypad.begin(NEOKEY_I2C_ADDRS, sizeof(NEOKEY_I2C_ADDRS)))
     {
         Serial.println(F("ERROR: NeoKey init failed."));
         g_statusLed.setState(StatusLED::State::Error);
@@ -35,7 +399,7 @@ void setup()
         }
     }
     g_keypad.setPressedColor(seesaw_NeoPixel::Color(0, 180, 60));
-    g_keypad.setDebounceTime(50); // 50ms debounce time
+    g_keypad.setDebounceTime(50, KEYPAD_SCAN_INTERVAL_MS); // 50ms debounce time
 
     if (!g_encoder.begin(ENCODER_I2C_ADDR, ENCODER_PIXEL_BRIGHTNESS))
     {
@@ -48,8 +412,40 @@ void setup()
         }
     }
 
-    // Initialize CAN controller
-    if (!g_can.begin(CAN_BAUDRATE))
+    if (!LittleFS.begin())
+    {
+        Serial.println(F("WARNING: LittleFS mount failed."));
+    }
+
+    // Warm start: the last snapshot is applied before CAN comes up so bound
+    // LEDs light straight away; its values are stale until live frames arrive.
+    bool warm = g_warm.restore(WARM_START_SIGNALS);
+    loadRules();
+    if (warm)
+    {
+        uint32_t applyStart = micros();
+        applyWarmStart();
+        uint32_t applyUs = micros() - applyStart;
+        Serial.print(F("Warm start: "));
+        Serial.print(__builtin_popcountl(g_warm.staleMask()));
+        Serial.print(F(" signals restored in "));
+        Serial.print(g_warm.loadUs() + applyUs);
+        Serial.print(F(" us (read "));
+        Serial.print(g_warm.loadUs());
+        Serial.println(F(" us)"));
+    }
+    uint32_t lastBitrate = g_warm.snapshot().bitrate;
+
+    // Initialize CAN controller, detecting the bus bitrate first if
+    // CAN_AUTO_BAUD is set (the last known rate is tried first). A quiet bus falls back to the
+    // last known rate, then to the default, which is not saved over it.
+    bool canOk = CAN_AUTO_BAUD && autoBaud(lastBitrate);
+    if (!canOk && lastBitrate)
+        canOk = g_can.begin(lastBitrate);
+    bool defaultRate = !canOk;
+    if (defaultRate)
+        canOk = g_can.begin(CAN_BAUDRATE);
+    if (!canOk)
     {
         Serial.println(F("ERROR: MCP2515 init failed."));
         g_statusLed.setState(StatusLED::State::Error);
@@ -65,7 +461,25 @@ void setup()
         // Enable decoded output by default; raw traffic can be toggled later.
         g_can.setDebugDecoded(false);
         g_can.setDebugRaw(false);
+        g_can.setSampleHandler(recordSample, nullptr);
+        if (!defaultRate)
+            g_warm.setBitrate(g_can.bitrate());
     }
+    g_isotp.begin();
+    g_uds.setFlowControl(ISOTP_RX_BLOCK_SIZE, ISOTP_RX_STMIN_MS);
+
+    g_console.addCommand("hist", cmdHist, "hist [signal] - signal history");
+    g_console.addCommand("baud", cmdBaud, "baud [auto|<bps>] - show or change CAN bitrate");
+    g_console.addCommand("bench", cmdBench, "bench [frames] - CAN loopback self-test");
+    g_console.addCommand("replay", cmdReplay, "replay <file> [speed%] [loop] | stop | stats | ... - trace playback");
+    g_console.addCommand("did", cmdDid, "did <req_id> <did> [bytes...] - UDS read/write DID");
+    g_console.addCommand("stats", cmdStats, "stats [reset] - CAN RX change-detection counters");
+    g_console.addCommand("rules", cmdRules, "rules [reload|default] - signal rules");
+    g_console.addCommand("warm", cmdWarm, "warm [save] - warm-start snapshot status");
+#ifdef CAN_PROFILE
+    CanProfile::begin();
+    g_console.addCommand("prof", cmdProf, "prof [reset] - CAN path cost per ID and stage");
+#endif
 
     Serial.println(F("Setup complete."));
     g_statusLed.setState(StatusLED::State::Ok);
@@ -75,16 +489,27 @@ void loop()
 {
     static uint32_t lastKeypadMs = 0;
     static uint32_t lastEncoderMs = 0;
+    static bool chordHeld = false;
     uint32_t now = millis();
 
     // Fast CAN drain every iteration.
     g_can.poll();
+    g_replay.service();
+    g_isotp.service();
+    g_uds.service();
+    g_console.update();
 
     // Keypad at configured interval
     if (now - lastKeypadMs >= KEYPAD_SCAN_INTERVAL_MS)
     {
         lastKeypadMs = now;
         g_keypad.update();
+
+        // Key chord starts the loopback benchmark (once per press).
+        bool chord = (g_keypad.buttons() & BENCH_KEY_CHORD) == BENCH_KEY_CHORD;
+        if (chord && !chordHeld)
+            runBenchmark(CAN_BENCH_FRAMES);
+        chordHeld = chord;
     }
     // Encoder at configured interval
     if (now - lastEncoderMs >= ENCODER_SCAN_INTERVAL_MS)
@@ -95,52 +520,47 @@ void loop()
     // Status LED animation already self-throttles internally
     g_statusLed.update();
 
-    // React to VCFRONT_indicator requests: illuminate button LEDs to show indicator status
+    // Decoded changes drive the rule engine (indicator LEDs etc.)
     if (g_can.hasNewFrontLighting())
     {
-        static CANManager::IndicatorReq lastLeft = (CANManager::IndicatorReq)0xFF;
-        static CANManager::IndicatorReq lastRight = (CANManager::IndicatorReq)0xFF;
         auto fl = g_can.getFrontLighting();
-
-        if (fl.indicatorLeftRequest != lastLeft)
-        {
-            bool isLeftActive = fl.indicatorLeftRequest == CANManager::IndicatorReq::ActiveLow || fl.indicatorLeftRequest == CANManager::IndicatorReq::ActiveHigh;
-            bool isLeftHigh = fl.indicatorLeftRequest == CANManager::IndicatorReq::ActiveHigh;
-            if(isLeftActive) {
-                g_keypad.setKeyColor(2, isLeftHigh ? 255 : 128, isLeftHigh ? 120 : 60, 0);
-            } else {
-                g_keypad.setKeyColor(2, 0, 0, 0);
-            }
-            lastLeft = fl.indicatorLeftRequest;
-        }
-        if (fl.indicatorRightRequest != lastRight)
-        {
-            bool isRightActive = fl.indicatorRightRequest == CANManager::IndicatorReq::ActiveLow || fl.indicatorRightRequest == CANManager::IndicatorReq::ActiveHigh;
-            bool isRightHigh = fl.indicatorRightRequest == CANManager::IndicatorReq::ActiveHigh;
-            if(isRightActive) {
-                g_keypad.setKeyColor(3, isRightHigh ? 255 : 128, isRightHigh ? 120 : 60, 0);
-            } else {
-                g_keypad.setKeyColor(3, 0, 0, 0);
-            }
-            lastRight = fl.indicatorRightRequest;
-        }
+        publishSignal(SignalId::IndicatorLeft, (int32_t)fl.indicatorLeftRequest);
+        publishSignal(SignalId::IndicatorRight, (int32_t)fl.indicatorRightRequest);
+    }
+    if (g_can.hasNewRightDoorStatus())
+    {
+        auto door = g_can.getRightDoorStatus();
+        publishSignal(SignalId::RearIntSwitch, door.rearIntSwitchPressed);
+    }
+    if (g_can.hasNewSCCMLeftStalk())
+    {
+        auto stalk = g_can.getSCCMLeftStalk();
+        publishSignal(SignalId::HighBeamStalk, (int32_t)stalk.highBeamStalkStatus);
+        publishSignal(SignalId::TurnStalk, (int32_t)stalk.turnIndicatorStalkStatus);
+        publishSignal(SignalId::WashWipe, (int32_t)stalk.washWipeButtonStatus);
     }
+    g_rules.update(now);
+    g_warm.service(now);
+    // Restored state that no live frame confirmed in time goes dark.
+    for (uint32_t m = g_warm.expire(now); m; m &= m - 1)
+        g_rules.dropSignal((SignalId)__builtin_ctzl(m));
 
-    uint8_t jp = g_keypad.justPressed();
-    uint8_t jr = g_keypad.justReleased();
+    uint32_t jp = g_keypad.justPressed();
+    uint32_t jr = g_keypad.justReleased();
     if (jp || jr)
     {
         if (jp)
         {
-            for (uint8_t i = 0; i < 4; i++)
+            for (uint8_t i = 0; i < g_keypad.keyCount(); i++)
             {
-                if (jp & (1 << i))
+                if (jp & (1UL << i))
                 {
                     Serial.print(F("Key "));
                     Serial.print(i);
                     Serial.println(F(" pressed"));
-                    // Debug toggles
-                    if (i == 0)
+                    // Debug toggles, except as part of the bench chord
+                    bool chordKey = chordHeld && (BENCH_KEY_CHORD & (1UL << i));
+                    if (i == 0 && !chordKey)
                     {
                         static bool raw = false;
                         raw = !raw;
@@ -148,7 +568,7 @@ void loop()
                         Serial.print(F("CAN raw debug="));
                         Serial.println(raw ? F("ON") : F("OFF"));
                     }
-                    else if (i == 1)
+                    else if (i == 1 && !chordKey)
                     {
                         static bool dec = false;
                         dec = !dec;
@@ -169,9 +589,9 @@ void loop()
         }
         if (jr)
         {
-            for (uint8_t i = 0; i < 4; i++)
+            for (uint8_t i = 0; i < g_keypad.keyCount(); i++)
             {
-                if (jr & (1 << i))
+                if (jr & (1UL << i))
                 {
                     Serial.print(F("Key "));
                     Serial.print(i);
@@ -0,0 +1,146 @@
+// Frame layout tests for the CanSignal descriptors behind CANManager: TX/RX
+// symmetry, wire bit positions, minimum lengths and range enforcement (and
+// where it is compiled out).
+// Run with `pio test -e native`.
+#include <unity.h>
+#include "CANManager.h"
+
+namespace
+{
+    using Stalk = CANManager::SCCMLeftStalkMsg;
+
+    Stalk makeStalk()
+    {
+        Stalk s;
+        s.leftStalkCrc = 0xA5;
+        s.leftStalkCounter = 5;
+        s.highBeamStalkStatus = CANManager::HighBeamStalkStatus::Pull;
+        s.washWipeButtonStatus = CANManager::WashWipeButtonStatus::FirstDetent;
+        s.turnIndicatorStalkStatus = CANManager::TurnIndicatorStalkStatus::Down2;
+        s.reserved = 0x11;
+        return s;
+    }
+
+    // Motorola placement: a 12-bit signal with MSB at DBC bit 7 fills byte 0
+    // and the high nibble of byte 1.
+    struct MotorolaProbe
+    {
+        uint16_t value = 0;
+    };
+    using MotorolaFrame = CanSignal::Message<
+        0x100, 2,
+        CanSignal::Field<&MotorolaProbe::value, 7, 12, CanSignal::ByteOrder::Motorola>>;
+}
+
+void setUp() {}
+void tearDown() {}
+
+void test_stalk_round_trip()
+{
+    uint8_t data[8] = {0};
+    TEST_ASSERT_TRUE(CANManager::SCCMLeftStalkFrame::pack(makeStalk(), data));
+    Stalk in = makeStalk();
+    Stalk out;
+    TEST_ASSERT_TRUE(CANManager::SCCMLeftStalkFrame::unpack(data, out));
+    TEST_ASSERT_EQUAL_UINT8(in.leftStalkCrc, out.leftStalkCrc);
+    TEST_ASSERT_EQUAL_UINT8(in.leftStalkCounter, out.leftStalkCounter);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)in.highBeamStalkStatus, (uint8_t)out.highBeamStalkStatus);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)in.washWipeButtonStatus, (uint8_t)out.washWipeButtonStatus);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)in.turnIndicatorStalkStatus, (uint8_t)out.turnIndicatorStalkStatus);
+    TEST_ASSERT_EQUAL_UINT8(in.reserved, out.reserved);
+}
+
+void test_stalk_wire_bytes()
+{
+    uint8_t data[8] = {0};
+    CANManager::SCCMLeftStalkFrame::pack(makeStalk(), data);
+    // counter 5 | Pull << 4 | FirstDetent << 6, Down2 | 0x11 << 3
+    const uint8_t expected[4] = {0xA5, 0x55, 0x8C, 0x00};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, data, 4);
+}
+
+void test_min_lengths()
+{
+    TEST_ASSERT_EQUAL_UINT8(3, CANManager::SCCMLeftStalkFrame::kMinLen);
+    TEST_ASSERT_EQUAL_UINT8(1, CANManager::FrontLightingFrame::kMinLen);
+    TEST_ASSERT_EQUAL_UINT8(5, CANManager::RightDoorStatusFrame::kMinLen);
+}
+
+void test_door_switch_is_bit_32()
+{
+    uint8_t data[8] = {0, 0, 0, 0, 0x01, 0, 0, 0};
+    CANManager::RightDoorStatusMsg m;
+    TEST_ASSERT_TRUE(CANManager::RightDoorStatusFrame::unpack(data, m));
+    TEST_ASSERT_TRUE(m.rearIntSwitchPressed);
+}
+
+void test_lighting_indicator_bits()
+{
+    uint8_t data[8] = {0x09, 0, 0, 0, 0, 0, 0, 0};
+    CANManager::FrontLightingMsg m;
+    TEST_ASSERT_TRUE(CANManager::FrontLightingFrame::unpack(data, m));
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)CANManager::IndicatorReq::ActiveLow, (uint8_t)m.indicatorLeftRequest);
+    TEST_ASSERT_EQUAL_UINT8((uint8_t)CANManager::IndicatorReq::ActiveHigh, (uint8_t)m.indicatorRightRequest);
+}
+
+void test_motorola_layout()
+{
+    MotorolaProbe in;
+    in.value = 0xABC;
+    uint8_t data[8] = {0};
+    TEST_ASSERT_TRUE(MotorolaFrame::pack(in, data));
+    MotorolaProbe out;
+    TEST_ASSERT_TRUE(MotorolaFrame::unpack(data, out));
+    TEST_ASSERT_EQUAL_HEX8(0xAB, data[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xC0, data[1]);
+    TEST_ASSERT_EQUAL_HEX16(0xABC, out.value);
+    TEST_ASSERT_TRUE(MotorolaFrame::kSignalMask == 0xF0FFull);
+}
+
+void test_pack_rejects_out_of_range()
+{
+    Stalk s = makeStalk();
+    s.turnIndicatorStalkStatus = (CANManager::TurnIndicatorStalkStatus)6; // past SNA
+    uint8_t data[8] = {0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A, 0x5A};
+    TEST_ASSERT_FALSE(CANManager::SCCMLeftStalkFrame::pack(s, data));
+    TEST_ASSERT_EACH_EQUAL_HEX8(0x5A, data, 8); // left untouched
+}
+
+void test_unpack_flags_out_of_range()
+{
+    uint8_t data[8] = {0};
+    CANManager::SCCMLeftStalkFrame::pack(makeStalk(), data);
+    data[2] = (uint8_t)((data[2] & ~0x07) | 7); // turn status 7
+    Stalk out;
+    TEST_ASSERT_FALSE(CANManager::SCCMLeftStalkFrame::unpack(data, out));
+    TEST_ASSERT_EQUAL_UINT8(7, (uint8_t)out.turnIndicatorStalkStatus);
+    TEST_ASSERT_EQUAL_UINT8(0xA5, out.leftStalkCrc); // other fields still decoded
+}
+
+void test_range_checks_only_where_needed()
+{
+    // Full-width fields in a wide-enough member carry no range check.
+    using Counter = CanSignal::Field<&Stalk::leftStalkCounter, 8, 4>;
+    using Turn = CanSignal::Field<&Stalk::turnIndicatorStalkStatus, 16, 3, CanSignal::ByteOrder::Intel, 0, 5>;
+    TEST_ASSERT_FALSE(Counter::kRawChecked);
+    TEST_ASSERT_TRUE(Turn::kRawChecked);
+    TEST_ASSERT_FALSE((CanSignal::canExceed<bool, 0, 1>()));
+    TEST_ASSERT_FALSE((CanSignal::canExceed<uint8_t, 0, 255>()));
+    TEST_ASSERT_TRUE((CanSignal::canExceed<uint8_t, 0, 15>()));
+    TEST_ASSERT_TRUE((CanSignal::canExceed<int8_t, 0, 255>()));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_stalk_round_trip);
+    RUN_TEST(test_stalk_wire_bytes);
+    RUN_TEST(test_min_lengths);
+    RUN_TEST(test_door_switch_is_bit_32);
+    RUN_TEST(test_lighting_indicator_bits);
+    RUN_TEST(test_motorola_layout);
+    RUN_TEST(test_pack_rejects_out_of_range);
+    RUN_TEST(test_unpack_flags_out_of_range);
+    RUN_TEST(test_range_checks_only_where_needed);
+    return UNITY_END();
+}